@@ -0,0 +1,87 @@
+#!/bin/sh
+
+# Runs a short fixed benchmark with Mesa's llvmpipe software renderer
+# and compares the frame rates with a saved baseline. The exit status
+# is 2 if any run is more than BENCH_THRESHOLD percent slower than the
+# baseline.
+#
+# BENCH_THRESHOLD defaults to 10 rather than the 5 percent that the
+# program uses on its own. Each run is only BENCH_FRAMES frames on a
+# software renderer that shares the CPU with the rest of the build
+# machine, so the frame rates are noisier than a longer run on real
+# hardware and a tighter gate would fail on noise.
+#
+# usage: bench.sh PROGRAM [BASELINE]
+#
+# The results are written to bench-results.txt in the current
+# directory. Frame rates depend on the machine so no baseline is
+# shipped. If BASELINE is given but doesn't exist yet the benchmark
+# still runs so that there are results to copy to BASELINE, but the
+# exit status is 1 so that a missing baseline never passes as a
+# successful check.
+#
+# The benchmark runs under xvfb-run with GLX if it is available and
+# otherwise falls back to the headless EGL backend.
+
+test -n "$srcdir" || srcdir=`dirname "$0"`
+test -n "$srcdir" || srcdir=.
+
+prog="$1"
+baseline="$2"
+
+if test -z "$prog"; then
+        echo "usage: $0 PROGRAM [BASELINE]" >&2
+        exit 1
+fi
+
+case "$prog" in
+        /*) ;;
+        *) prog="`pwd`/$prog" ;;
+esac
+
+results="`pwd`/bench-results.txt"
+
+case "$baseline" in
+        ""|/*) ;;
+        *) baseline="`pwd`/$baseline" ;;
+esac
+
+LIBGL_ALWAYS_SOFTWARE=1
+GALLIUM_DRIVER=llvmpipe
+export LIBGL_ALWAYS_SOFTWARE GALLIUM_DRIVER
+
+set -- \
+        --frames="${BENCH_FRAMES:-200}" \
+        --contexts=1,4 \
+        --release=none,flush \
+        --format=text
+
+missing_baseline=no
+
+if test -n "$baseline" && test -f "$baseline"; then
+        set -- "$@" \
+                --baseline="$baseline" \
+                --threshold="${BENCH_THRESHOLD:-10}"
+elif test -n "$baseline"; then
+        missing_baseline=yes
+fi
+
+# The shaders are loaded from the current directory
+cd "$srcdir" || exit 1
+
+if command -v xvfb-run > /dev/null 2>&1; then
+        xvfb-run -a -s "-screen 0 1280x1024x24" \
+                "$prog" --platform=glx "$@" > "$results"
+else
+        "$prog" --platform=egl "$@" > "$results"
+fi
+status=$?
+
+cat "$results"
+
+if test "$missing_baseline" = yes; then
+        echo "$baseline doesn't exist, copy $results there to make it" >&2
+        test $status -eq 0 && status=1
+fi
+
+exit $status
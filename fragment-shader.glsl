@@ -31,8 +31,41 @@ layout(location = 0) out vec4 frag_color;
 
 in vec3 color;
 
+#ifdef TEXTURE_SAMPLES
+uniform sampler2D noise_tex;
+#endif
+
 void
 main()
 {
-        frag_color = vec4(color, 1.0);
+        vec3 extra = vec3(0.0);
+
+#ifdef FRAGMENT_ALU
+        float x = gl_FragCoord.x * 0.001 + gl_FragCoord.y * 0.0001;
+
+        /* A dependent chain so that every iteration is executed */
+        for (int i = 0; i < FRAGMENT_ALU; i++)
+                x = fract(x * 1.618034 + 0.414214);
+
+        extra.g += x;
+#endif
+
+#ifdef TEXTURE_SAMPLES
+        vec2 coord = gl_FragCoord.xy / 256.0;
+        vec3 samples = vec3(0.0);
+
+        for (int i = 0; i < TEXTURE_SAMPLES; i++) {
+                samples += texture(noise_tex, coord).rgb;
+                coord += vec2(0.37, 0.71);
+        }
+
+        /* The average keeps the result in [0,1] however many
+         * samples are taken */
+        extra += samples / float(TEXTURE_SAMPLES);
+#endif
+
+        /* Each part of the extra work is in [0,1] so even together
+         * with the vertex work this stays well under half of an
+         * 8-bit step and doesn't change the color */
+        frag_color = vec4(color + extra * 1.0e-4, 1.0);
 }
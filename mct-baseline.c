@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mct-baseline.h"
+
+#define RUN_PREFIX "run: "
+
+struct mct_baseline {
+        char **lines;
+        int n_lines;
+};
+
+struct mct_baseline *
+mct_baseline_load(const char *filename)
+{
+        struct mct_baseline *baseline;
+        char *line = NULL;
+        size_t line_size = 0;
+        ssize_t got;
+        int size = 8;
+        FILE *in;
+
+        in = fopen(filename, "r");
+        if (in == NULL) {
+                fprintf(stderr, "%s: %m\n", filename);
+                return NULL;
+        }
+
+        baseline = malloc(sizeof *baseline);
+        baseline->n_lines = 0;
+        baseline->lines = malloc(sizeof *baseline->lines * size);
+
+        while ((got = getline(&line, &line_size, in)) != -1) {
+                if (strncmp(line, RUN_PREFIX, strlen(RUN_PREFIX)))
+                        continue;
+
+                if (got > 0 && line[got - 1] == '\n')
+                        line[got - 1] = '\0';
+
+                if (baseline->n_lines >= size) {
+                        size *= 2;
+                        baseline->lines = realloc(baseline->lines,
+                                                  sizeof *baseline->lines *
+                                                  size);
+                }
+
+                baseline->lines[baseline->n_lines++] =
+                        strdup(line + strlen(RUN_PREFIX));
+        }
+
+        free(line);
+        fclose(in);
+
+        if (baseline->n_lines == 0) {
+                fprintf(stderr, "%s: no run records found\n", filename);
+                mct_baseline_free(baseline);
+                return NULL;
+        }
+
+        return baseline;
+}
+
+/* Returns the value of the field with the given name or NULL. The
+ * value ends at the next space. */
+static const char *
+find_field(const char *line,
+           const char *name,
+           size_t name_length)
+{
+        const char *p;
+
+        for (p = line; p; p = strchr(p, ' ')) {
+                if (*p == ' ')
+                        p++;
+
+                if (!strncmp(p, name, name_length) && p[name_length] == '=')
+                        return p + name_length + 1;
+        }
+
+        return NULL;
+}
+
+static bool
+line_matches(const char *line,
+             const char *key)
+{
+        const char *field, *equals, *end, *value;
+        size_t value_length;
+
+        for (field = key; *field; field = end) {
+                while (*field == ' ')
+                        field++;
+                if (*field == '\0')
+                        break;
+
+                end = strchr(field, ' ');
+                if (end == NULL)
+                        end = field + strlen(field);
+
+                equals = memchr(field, '=', end - field);
+                if (equals == NULL)
+                        return false;
+
+                value = find_field(line, field, equals - field);
+                value_length = end - equals - 1;
+
+                if (value == NULL ||
+                    strncmp(value, equals + 1, value_length) ||
+                    (value[value_length] != ' ' &&
+                     value[value_length] != '\0'))
+                        return false;
+        }
+
+        return true;
+}
+
+bool
+mct_baseline_lookup(const struct mct_baseline *baseline,
+                    const char *key,
+                    const char *field,
+                    double *value)
+{
+        const char *line, *field_value;
+        char *tail;
+        int i;
+
+        for (i = 0; i < baseline->n_lines; i++) {
+                line = baseline->lines[i];
+
+                if (!line_matches(line, key))
+                        continue;
+
+                field_value = find_field(line, field, strlen(field));
+                if (field_value == NULL)
+                        return false;
+
+                *value = strtod(field_value, &tail);
+
+                return tail > field_value;
+        }
+
+        return false;
+}
+
+void
+mct_baseline_free(struct mct_baseline *baseline)
+{
+        int i;
+
+        for (i = 0; i < baseline->n_lines; i++)
+                free(baseline->lines[i]);
+
+        free(baseline->lines);
+        free(baseline);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MCT_BASELINE_H
+#define MCT_BASELINE_H
+
+#include <stdbool.h>
+
+/* Results from an earlier run to compare against. The file is the
+ * text report of that run, so a baseline can be made by saving the
+ * output with -f text. Each run record is found by the fields that
+ * identify it, which can be anywhere in the record. */
+
+struct mct_baseline;
+
+/* Returns NULL and prints an error if the file can't be read */
+struct mct_baseline *
+mct_baseline_load(const char *filename);
+
+/* Finds the first run record that contains every name=value field of
+ * the space-separated key and gets the numeric value of field from
+ * it. Returns false if there is no such record or field. */
+bool
+mct_baseline_lookup(const struct mct_baseline *baseline,
+                    const char *key,
+                    const char *field,
+                    double *value);
+
+void
+mct_baseline_free(struct mct_baseline *baseline);
+
+#endif /* MCT_BASELINE_H */
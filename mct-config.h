@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_CONFIG_H
+#define MCT_CONFIG_H
+
+enum mct_mode {
+        /* Switch between all of the contexts on the main thread */
+        MCT_MODE_SINGLE,
+        /* Each context has its own thread and is never switched */
+        MCT_MODE_THREADED,
+        /* Each context has its own process */
+        MCT_MODE_PROCESS,
+        /* Each context is a tenant that draws its whole frame in
+         * turn on the main thread with a context from a pool */
+        MCT_MODE_POOL
+};
+
+enum mct_target {
+        /* Draw to the window's back buffer and swap it */
+        MCT_TARGET_WINDOW,
+        /* Draw to a framebuffer object for each context */
+        MCT_TARGET_FBO,
+        /* The same but the contexts don't have any drawable */
+        MCT_TARGET_SURFACELESS
+};
+
+enum mct_vertex_format {
+        MCT_VERTEX_FORMAT_FLOAT,
+        MCT_VERTEX_FORMAT_HALF,
+        /* Normalized signed shorts */
+        MCT_VERTEX_FORMAT_SNORM16
+};
+
+enum mct_sync {
+        /* Rely only on the release behavior */
+        MCT_SYNC_NONE,
+        /* glFlush before switching away from a context */
+        MCT_SYNC_FLUSH,
+        /* glFinish before switching away from a context */
+        MCT_SYNC_FINISH,
+        /* A fence before switching that the next context waits for
+         * on the GPU with glWaitSync */
+        MCT_SYNC_FENCE_SERVER,
+        /* The same but waited for on the CPU with glClientWaitSync */
+        MCT_SYNC_FENCE_CLIENT
+};
+
+enum mct_uniforms {
+        /* Set the per-frame state with glUniform */
+        MCT_UNIFORMS_PLAIN,
+        /* Upload the state into a uniform buffer for each context */
+        MCT_UNIFORMS_UBO,
+        /* Upload each context's state into its own range of a
+         * single buffer in the share group */
+        MCT_UNIFORMS_SHARED_UBO
+};
+
+/* The parameters of a single benchmark run. All of the members are
+ * ints so that the sweep code in multi-context-test.c can iterate
+ * over any of them generically. The members at the end aren't swept
+ * and are the same for every run. */
+
+struct mct_config {
+        int n_contexts;
+
+        /* Number of quads along each row of the grid and number of
+         * rows. Each row is drawn with a separate draw call */
+        int grid_width;
+        int grid_height;
+
+        /* Generate the grid positions in the vertex shader from
+         * gl_VertexID instead of storing them in a buffer */
+        int procedural_grid;
+
+        /* enum mct_vertex_format of the grid buffer */
+        int vertex_format;
+
+        /* Rewrite the grid every frame into a persistently mapped
+         * ring buffer instead of uploading it once */
+        int stream;
+
+        /* Extra GPU work to make each context's frame more realistic.
+         * The ALU members are iterations of a dependent loop per
+         * vertex or fragment, overdraw is the number of times each
+         * row is drawn and texture_samples is the number of texture
+         * fetches per fragment. */
+        int vertex_alu;
+        int fragment_alu;
+        int overdraw;
+        int texture_samples;
+
+        /* enum mct_uniforms to upload the per-frame state with.
+         * The shared buffer needs the contexts to be shared. */
+        int uniforms;
+
+        /* enum mct_sync between drawing with one context and the
+         * next. The fence modes need the contexts to be shared. */
+        int sync;
+
+        /* Skip making a window current if it already is */
+        int make_current_cache;
+
+        /* Swap interval for every window. Zero disables vsync */
+        int swap_interval;
+
+        /* Number of consecutive rows drawn with one glMultiDrawArrays
+         * call after each context switch */
+        int rows_per_switch;
+
+        /* Size of each window */
+        int width;
+        int height;
+
+        /* enum mct_target to draw to */
+        int target;
+
+        int flush_on_release;
+
+        /* enum mct_mode */
+        int mode;
+
+        /* Maximum number of contexts in pool mode. Zero gives every
+         * tenant its own context. */
+        int pool_size;
+
+        /* Put all of the contexts in one share group and create the
+         * grid buffer and program only once */
+        int share;
+
+        /* Submit the programs for all of the contexts before waiting
+         * for any of them to compile */
+        int parallel_compile;
+
+        /* Measure per-context GPU time with timer queries */
+        int gpu_timing;
+
+        /* Measure when each swap reaches the screen */
+        int present_timing;
+
+        /* Count CPU events around the phases with perf_event_open */
+        int perf_counters;
+
+        /* Read back every frame and compare it with a reference */
+        int verify;
+
+        /* Sample the process and video memory around creating each
+         * context */
+        int memory;
+};
+
+#endif /* MCT_CONFIG_H */
@@ -0,0 +1,963 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * Authors:
+ *    Neil Roberts <neil@linux.intel.com>
+ *
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "mct-draw-state.h"
+#include "mct-timing.h"
+#include "mct-stream.h"
+#include "mct-readback.h"
+#include "mct-memory.h"
+#include "shader-data.h"
+
+/* Number of different band positions drawn when verifying. Each one
+ * has a reference hash. */
+#define N_VERIFY_BANDS 16
+
+/* Size of the noise texture sampled when texture_samples is set */
+#define NOISE_TEXTURE_SIZE 256
+
+/* Contents of the frame_state uniform block with the std140
+ * layout */
+struct mct_frame_state {
+        float band_pos;
+        float padding[3];
+};
+
+struct mct_draw_state {
+        GLuint grid_buffer;
+        GLuint grid_array;
+
+        GLuint prog;
+        /* Program that is still being compiled. The program can't
+         * be used until mct_draw_state_finish is called */
+        struct shader_data_program *pending_prog;
+
+        GLuint band_pos_location;
+
+        /* Zero unless the per-frame state is in a uniform buffer. For
+         * shared-ubo this is shared and each draw state has its own
+         * range of it. */
+        enum mct_uniforms uniforms;
+        GLuint uniform_buffer;
+        GLintptr uniform_offset;
+        /* Number of ranges of the shared buffer handed out so far */
+        int n_uniform_ranges;
+
+        /* Zero unless the fragment shader samples a texture */
+        GLuint noise_texture;
+        /* Number of times each row is drawn */
+        int overdraw;
+
+        /* False if the buffer, texture and program belong to another
+         * draw state in the same share group */
+        bool owns_shared_objects;
+        size_t grid_buffer_size;
+        /* Memory used by make_grid if it was sampled */
+        struct mct_memory_usage grid_memory;
+        /* Amount of vertex data fetched to draw the whole grid */
+        size_t frame_vertex_bytes;
+        enum mct_vertex_format vertex_format;
+
+        /* NULL unless the grid is rewritten every frame. In that
+         * case grid_buffer is zero. */
+        struct mct_stream *stream;
+        uint64_t stream_write_time;
+
+        int grid_width;
+        int grid_height;
+
+        /* Arguments for glMultiDrawArrays for every row */
+        GLint *row_firsts;
+        GLsizei *row_counts;
+
+        /* NULL unless GPU timing is enabled */
+        struct mct_gpu_timer *gpu_timer;
+
+        /* Zero unless drawing offscreen */
+        GLuint fbo;
+        GLuint color_buffer;
+        int width;
+        int height;
+
+        /* When verifying the band position cycles through a fixed
+         * set so that each frame can be compared with a reference */
+        bool verify;
+        int frame_count;
+        int band;
+        uint64_t reference[N_VERIFY_BANDS];
+        /* Only created after the references are drawn */
+        struct mct_readback *readback;
+};
+
+struct mct_vertex_format_info {
+        GLenum type;
+        GLboolean normalized;
+        /* Size of a whole vertex */
+        size_t size;
+};
+
+static const struct mct_vertex_format_info
+vertex_formats[] = {
+        [MCT_VERTEX_FORMAT_FLOAT] = {
+                GL_FLOAT, GL_FALSE, sizeof (float) * 2
+        },
+        [MCT_VERTEX_FORMAT_HALF] = {
+                GL_HALF_FLOAT, GL_FALSE, sizeof (uint16_t) * 2
+        },
+        [MCT_VERTEX_FORMAT_SNORM16] = {
+                GL_SHORT, GL_TRUE, sizeof (int16_t) * 2
+        },
+};
+
+static uint16_t
+float_to_half(float value)
+{
+        union { float f; uint32_t i; } u = { value };
+        uint32_t sign = (u.i >> 16) & 0x8000;
+        int exponent = ((u.i >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = u.i & 0x7fffff;
+
+        /* The grid positions are all in [-1,1] so there's no need to
+         * handle denormals, infinity or NaN carefully */
+        if (exponent <= 0)
+                return sign;
+
+        /* Round to nearest */
+        mantissa += 0x1000;
+        if (mantissa & 0x800000) {
+                mantissa = 0;
+                exponent++;
+        }
+
+        if (exponent >= 31)
+                return sign | 0x7c00;
+
+        return sign | (exponent << 10) | (mantissa >> 13);
+}
+
+static void
+store_position(uint8_t *vertex,
+               enum mct_vertex_format format,
+               float x,
+               float y)
+{
+        float *f = (float *) vertex;
+        uint16_t *h = (uint16_t *) vertex;
+        int16_t *sn = (int16_t *) vertex;
+
+        switch (format) {
+        case MCT_VERTEX_FORMAT_FLOAT:
+                f[0] = x;
+                f[1] = y;
+                break;
+        case MCT_VERTEX_FORMAT_HALF:
+                h[0] = float_to_half(x);
+                h[1] = float_to_half(y);
+                break;
+        case MCT_VERTEX_FORMAT_SNORM16:
+                sn[0] = lrintf(x * 32767.0f);
+                sn[1] = lrintf(y * 32767.0f);
+                break;
+        }
+}
+
+static size_t
+get_grid_size(int width,
+              int height,
+              enum mct_vertex_format format)
+{
+        return vertex_formats[format].size * (width * 2 + 2) * height;
+}
+
+static void
+fill_grid(uint8_t *vertex,
+          int width,
+          int height,
+          enum mct_vertex_format format)
+{
+        size_t vertex_size = vertex_formats[format].size;
+        float sh;
+        float blx, bly;
+        int x, y;
+
+        /* Makes a grid of triangles where each line of quads is
+         * represented as a triangle strip. Each line is intended to
+         * drawn separately */
+
+        sh = 2.0f / height;
+
+        for (y = 0; y < height; y++) {
+                for (x = 0; x <= width; x++) {
+                        blx = x * 2.0f / width - 1.0f;
+                        bly = y * 2.0f / height - 1.0f;
+
+                        store_position(vertex, format, blx, bly + sh);
+                        vertex += vertex_size;
+
+                        store_position(vertex, format, blx, bly);
+                        vertex += vertex_size;
+                }
+        }
+}
+
+static size_t
+make_grid(GLuint *buffer,
+          int width,
+          int height,
+          enum mct_vertex_format format)
+{
+        size_t size = get_grid_size(width, height, format);
+        void *vertex;
+
+        glGenBuffers(1, buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, *buffer);
+        glBufferData(GL_ARRAY_BUFFER,
+                     size,
+                     NULL,
+                     GL_STATIC_DRAW);
+        vertex = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+
+        fill_grid(vertex, width, height, format);
+
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        return size;
+}
+
+static bool
+make_fbo(struct mct_draw_state *draw_state)
+{
+        GLenum status;
+
+        glGenRenderbuffers(1, &draw_state->color_buffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, draw_state->color_buffer);
+        glRenderbufferStorage(GL_RENDERBUFFER,
+                              GL_RGBA8,
+                              draw_state->width,
+                              draw_state->height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &draw_state->fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, draw_state->fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                  GL_COLOR_ATTACHMENT0,
+                                  GL_RENDERBUFFER,
+                                  draw_state->color_buffer);
+        status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        /* A surfaceless context starts with an empty viewport */
+        glViewport(0, 0, draw_state->width, draw_state->height);
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+                fprintf(stderr, "The framebuffer is incomplete (0x%x)\n",
+                        status);
+                return false;
+        }
+
+        return true;
+}
+
+static void
+make_grid_array(GLuint buffer,
+                enum mct_vertex_format format,
+                GLuint *array)
+{
+        const struct mct_vertex_format_info *info = vertex_formats + format;
+
+        /* Vertex arrays are container objects so they can't be
+         * shared and are always created per context */
+        glGenVertexArrays(1, array);
+
+        /* The procedural grid has no attributes but a core context
+         * still needs a vertex array to draw */
+        if (buffer == 0)
+                return;
+
+        glBindVertexArray(*array);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, /* index */
+                              2, /* size */
+                              info->type,
+                              info->normalized,
+                              info->size,
+                              (void *) 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+}
+
+static GLuint
+make_noise_texture(void)
+{
+        uint32_t *data = malloc(NOISE_TEXTURE_SIZE * NOISE_TEXTURE_SIZE *
+                                sizeof *data);
+        uint32_t state = 0x12345678;
+        GLuint texture;
+        int i;
+
+        /* xorshift so that the texture is the same on every run */
+        for (i = 0; i < NOISE_TEXTURE_SIZE * NOISE_TEXTURE_SIZE; i++) {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                data[i] = state;
+        }
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D,
+                     0, /* level */
+                     GL_RGBA8,
+                     NOISE_TEXTURE_SIZE, NOISE_TEXTURE_SIZE,
+                     0, /* border */
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        free(data);
+
+        return texture;
+}
+
+/* Enough for every define with the largest int values */
+#define MAX_DEFINES_LENGTH 256
+
+/* Returns false if the define didn't fit */
+static bool
+add_define(char *defines,
+           size_t size,
+           size_t *length,
+           const char *format,
+           ...)
+{
+        va_list ap;
+        int added;
+
+        va_start(ap, format);
+        added = vsnprintf(defines + *length, size - *length, format, ap);
+        va_end(ap);
+
+        if (added < 0 || (size_t) added >= size - *length)
+                return false;
+
+        *length += added;
+
+        return true;
+}
+
+/* The workload knobs are compiled into the shaders so that they
+ * don't add any uniforms or branches to the default program. Returns
+ * false if the defines didn't fit in the buffer. */
+static bool
+get_defines(const struct mct_config *config,
+            char *defines,
+            size_t size)
+{
+        size_t length = 0;
+
+        defines[0] = '\0';
+
+        if (config->procedural_grid &&
+            !add_define(defines, size, &length,
+                        "#define PROCEDURAL_GRID\n"))
+                return false;
+        if (config->vertex_alu > 0 &&
+            !add_define(defines, size, &length,
+                        "#define VERTEX_ALU %i\n",
+                        config->vertex_alu))
+                return false;
+        if (config->fragment_alu > 0 &&
+            !add_define(defines, size, &length,
+                        "#define FRAGMENT_ALU %i\n",
+                        config->fragment_alu))
+                return false;
+        if (config->texture_samples > 0 &&
+            !add_define(defines, size, &length,
+                        "#define TEXTURE_SAMPLES %i\n",
+                        config->texture_samples))
+                return false;
+        if (config->uniforms != MCT_UNIFORMS_PLAIN &&
+            !add_define(defines, size, &length,
+                        "#define UNIFORM_BLOCK\n"))
+                return false;
+
+        return true;
+}
+
+static GLuint
+make_uniform_buffer(size_t size)
+{
+        GLuint buffer;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        return buffer;
+}
+
+/* Size of each context's range of a shared uniform buffer */
+static size_t
+get_uniform_stride(void)
+{
+        GLint alignment;
+
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        return ((sizeof (struct mct_frame_state) + alignment - 1) /
+                alignment * alignment);
+}
+
+static void
+init_uniform_buffer(const struct mct_config *config,
+                    struct mct_draw_state *draw_state,
+                    struct mct_draw_state *share_state)
+{
+        draw_state->uniforms = config->uniforms;
+        draw_state->uniform_buffer = 0;
+        draw_state->uniform_offset = 0;
+        draw_state->n_uniform_ranges = 1;
+
+        switch ((enum mct_uniforms) config->uniforms) {
+        case MCT_UNIFORMS_PLAIN:
+                break;
+        case MCT_UNIFORMS_UBO:
+                draw_state->uniform_buffer =
+                        make_uniform_buffer(sizeof (struct mct_frame_state));
+                break;
+        case MCT_UNIFORMS_SHARED_UBO:
+                if (share_state) {
+                        draw_state->uniform_buffer =
+                                share_state->uniform_buffer;
+                        draw_state->uniform_offset =
+                                share_state->n_uniform_ranges++ *
+                                get_uniform_stride();
+                } else {
+                        draw_state->uniform_buffer =
+                                make_uniform_buffer(get_uniform_stride() *
+                                                    config->n_contexts);
+                }
+                break;
+        }
+}
+
+struct mct_draw_state *
+mct_draw_state_new(const struct mct_config *config,
+                   struct mct_draw_state *share_state)
+{
+        struct mct_draw_state *draw_state;
+        struct shader_data_program *pending_prog = NULL;
+        struct mct_stream *stream = NULL;
+        GLuint prog = 0;
+        struct mct_memory_sample memory_start, memory_end;
+        char defines[MAX_DEFINES_LENGTH];
+        int y;
+
+        if (config->stream) {
+                if (config->procedural_grid) {
+                        fprintf(stderr,
+                                "Streaming needs the grid in a buffer\n");
+                        return NULL;
+                }
+
+                stream = mct_stream_new(get_grid_size(config->grid_width,
+                                                      config->grid_height,
+                                                      config->vertex_format));
+                if (stream == NULL)
+                        return NULL;
+        }
+
+        if (share_state) {
+                prog = share_state->prog;
+        } else {
+                if (!get_defines(config, defines, sizeof defines)) {
+                        fprintf(stderr,
+                                "The shader defines are too long\n");
+                        if (stream)
+                                mct_stream_free(stream);
+                        return NULL;
+                }
+
+                pending_prog =
+                        shader_data_submit_program(defines,
+                                                   GL_VERTEX_SHADER,
+                                                   "vertex-shader.glsl",
+                                                   GL_FRAGMENT_SHADER,
+                                                   "fragment-shader.glsl",
+                                                   GL_NONE);
+
+                if (pending_prog == NULL) {
+                        if (stream)
+                                mct_stream_free(stream);
+                        return NULL;
+                }
+        }
+
+        draw_state = malloc(sizeof *draw_state);
+
+        draw_state->stream = stream;
+        draw_state->vertex_format = config->vertex_format;
+        mct_memory_usage_init(&draw_state->grid_memory);
+
+        if (share_state) {
+                draw_state->noise_texture = share_state->noise_texture;
+        } else if (config->texture_samples > 0) {
+                draw_state->noise_texture = make_noise_texture();
+        } else {
+                draw_state->noise_texture = 0;
+        }
+
+        if (share_state) {
+                draw_state->owns_shared_objects = false;
+                draw_state->grid_buffer = share_state->grid_buffer;
+                draw_state->grid_buffer_size = 0;
+        } else if (config->procedural_grid || stream) {
+                draw_state->owns_shared_objects = true;
+                draw_state->grid_buffer = 0;
+                draw_state->grid_buffer_size = 0;
+        } else {
+                draw_state->owns_shared_objects = true;
+                if (config->memory)
+                        mct_memory_sample(&memory_start, true);
+                draw_state->grid_buffer_size =
+                        make_grid(&draw_state->grid_buffer,
+                                  config->grid_width, config->grid_height,
+                                  config->vertex_format);
+                if (config->memory) {
+                        mct_memory_sample(&memory_end, true);
+                        mct_memory_usage_add(&draw_state->grid_memory,
+                                             &memory_start,
+                                             &memory_end,
+                                             1 /* count */);
+                }
+        }
+
+        if (stream) {
+                /* The attribute is pointed at the right segment
+                 * every frame */
+                make_grid_array(mct_stream_get_buffer(stream),
+                                config->vertex_format,
+                                &draw_state->grid_array);
+                draw_state->grid_buffer_size += mct_stream_get_size(stream);
+        } else {
+                make_grid_array(draw_state->grid_buffer,
+                                config->vertex_format,
+                                &draw_state->grid_array);
+        }
+
+        if (draw_state->grid_buffer || stream) {
+                draw_state->frame_vertex_bytes =
+                        vertex_formats[config->vertex_format].size *
+                        (config->grid_width * 2 + 2) *
+                        config->grid_height *
+                        config->overdraw;
+        } else {
+                draw_state->frame_vertex_bytes = 0;
+        }
+
+        draw_state->prog = prog;
+        draw_state->pending_prog = pending_prog;
+        draw_state->grid_width = config->grid_width;
+        draw_state->grid_height = config->grid_height;
+        draw_state->overdraw = config->overdraw;
+
+        init_uniform_buffer(config, draw_state, share_state);
+
+        draw_state->row_firsts =
+                malloc(sizeof *draw_state->row_firsts * config->grid_height);
+        draw_state->row_counts =
+                malloc(sizeof *draw_state->row_counts * config->grid_height);
+
+        for (y = 0; y < config->grid_height; y++) {
+                draw_state->row_counts[y] = config->grid_width * 2 + 2;
+                draw_state->row_firsts[y] = y * draw_state->row_counts[y];
+        }
+
+        if (config->gpu_timing)
+                draw_state->gpu_timer = mct_gpu_timer_new();
+        else
+                draw_state->gpu_timer = NULL;
+
+        draw_state->width = config->width;
+        draw_state->height = config->height;
+        draw_state->fbo = 0;
+        draw_state->color_buffer = 0;
+        draw_state->verify = config->verify;
+        draw_state->frame_count = 0;
+        draw_state->band = 0;
+        draw_state->readback = NULL;
+
+        if (config->target != MCT_TARGET_WINDOW && !make_fbo(draw_state)) {
+                mct_draw_state_free(draw_state);
+                return NULL;
+        }
+
+        return draw_state;
+}
+
+bool
+mct_draw_state_is_ready(struct mct_draw_state *draw_state)
+{
+        return (draw_state->pending_prog == NULL ||
+                shader_data_program_is_ready(draw_state->pending_prog));
+}
+
+/* Draws each of the band positions used when verifying without any
+ * context switching and records the hash of the result */
+static void
+draw_references(struct mct_draw_state *draw_state)
+{
+        struct mct_gpu_timer *gpu_timer = draw_state->gpu_timer;
+        int band;
+
+        /* The references shouldn't count as frames */
+        draw_state->gpu_timer = NULL;
+
+        for (band = 0; band < N_VERIFY_BANDS; band++) {
+                draw_state->frame_count = band;
+                mct_draw_state_start(draw_state);
+                mct_draw_state_draw_rows(draw_state,
+                                         0,
+                                         draw_state->grid_height);
+                glFinish();
+                draw_state->reference[band] =
+                        mct_readback_hash_now(draw_state->width,
+                                              draw_state->height);
+                mct_draw_state_end(draw_state);
+        }
+
+        draw_state->frame_count = 0;
+        draw_state->gpu_timer = gpu_timer;
+}
+
+bool
+mct_draw_state_finish(struct mct_draw_state *draw_state)
+{
+        if (draw_state->pending_prog) {
+                draw_state->prog =
+                        shader_data_finish_program(draw_state->pending_prog);
+                draw_state->pending_prog = NULL;
+        }
+
+        if (draw_state->prog == 0)
+                return false;
+
+        if (draw_state->uniforms == MCT_UNIFORMS_PLAIN) {
+                draw_state->band_pos_location =
+                        glGetUniformLocation(draw_state->prog, "band_pos");
+        } else {
+                glUniformBlockBinding(draw_state->prog,
+                                      glGetUniformBlockIndex(draw_state->prog,
+                                                             "frame_state"),
+                                      0 /* binding */);
+        }
+
+        if (draw_state->owns_shared_objects && draw_state->grid_buffer == 0) {
+                glUseProgram(draw_state->prog);
+                glUniform2i(glGetUniformLocation(draw_state->prog,
+                                                 "grid_size"),
+                            draw_state->grid_width,
+                            draw_state->grid_height);
+                glUseProgram(0);
+        }
+
+        if (draw_state->verify) {
+                draw_references(draw_state);
+                draw_state->readback =
+                        mct_readback_new(draw_state->width,
+                                         draw_state->height,
+                                         draw_state->reference);
+        }
+
+        return true;
+}
+
+static void
+write_stream(struct mct_draw_state *draw_state)
+{
+        const struct mct_vertex_format_info *info =
+                vertex_formats + draw_state->vertex_format;
+        uint64_t start_time;
+        size_t offset;
+        void *data;
+
+        data = mct_stream_begin(draw_state->stream, &offset);
+
+        /* The vertices are generated straight into the mapped
+         * buffer */
+        start_time = mct_get_time_ns();
+        fill_grid(data,
+                  draw_state->grid_width,
+                  draw_state->grid_height,
+                  draw_state->vertex_format);
+        draw_state->stream_write_time = mct_get_time_ns() - start_time;
+
+        glBindBuffer(GL_ARRAY_BUFFER,
+                     mct_stream_get_buffer(draw_state->stream));
+        glVertexAttribPointer(0, /* index */
+                              2, /* size */
+                              info->type,
+                              info->normalized,
+                              info->size,
+                              (void *) offset);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void
+set_band_pos(struct mct_draw_state *draw_state,
+             float band_pos)
+{
+        struct mct_frame_state frame_state = { .band_pos = band_pos };
+
+        if (draw_state->uniforms == MCT_UNIFORMS_PLAIN) {
+                glUniform1f(draw_state->band_pos_location, band_pos);
+                return;
+        }
+
+        /* The whole block is uploaded once per frame like a real
+         * renderer would */
+        glBindBufferRange(GL_UNIFORM_BUFFER,
+                          0, /* binding */
+                          draw_state->uniform_buffer,
+                          draw_state->uniform_offset,
+                          sizeof frame_state);
+        glBufferSubData(GL_UNIFORM_BUFFER,
+                        draw_state->uniform_offset,
+                        sizeof frame_state,
+                        &frame_state);
+}
+
+void
+mct_draw_state_start(struct mct_draw_state *draw_state)
+{
+        struct timeval tv;
+
+        if (draw_state->gpu_timer) {
+                mct_gpu_timer_begin(draw_state->gpu_timer);
+                mct_gpu_timer_begin_batch(draw_state->gpu_timer);
+        }
+
+        if (draw_state->fbo)
+                glBindFramebuffer(GL_FRAMEBUFFER, draw_state->fbo);
+
+        glBindVertexArray(draw_state->grid_array);
+        glUseProgram(draw_state->prog);
+
+        /* The sampler uniform is left at texture unit zero */
+        if (draw_state->noise_texture)
+                glBindTexture(GL_TEXTURE_2D, draw_state->noise_texture);
+
+        if (draw_state->stream)
+                write_stream(draw_state);
+
+        if (draw_state->verify) {
+                draw_state->band = draw_state->frame_count++ % N_VERIFY_BANDS;
+                set_band_pos(draw_state,
+                             (draw_state->band + 0.5f) / N_VERIFY_BANDS);
+        } else {
+                gettimeofday(&tv, NULL);
+                set_band_pos(draw_state, tv.tv_usec / 1000000.0f);
+        }
+
+        if (draw_state->gpu_timer)
+                mct_gpu_timer_end_batch(draw_state->gpu_timer);
+}
+
+void
+mct_draw_state_draw_rows(struct mct_draw_state *draw_state,
+                         int y,
+                         int n_rows)
+{
+        int i;
+
+        if (draw_state->gpu_timer)
+                mct_gpu_timer_begin_batch(draw_state->gpu_timer);
+
+        if (n_rows == 1 && draw_state->overdraw > 1) {
+                /* Instancing keeps the overdraw to one call so that
+                 * it only adds GPU work */
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP,
+                                      draw_state->row_firsts[y],
+                                      draw_state->row_counts[y],
+                                      draw_state->overdraw);
+        } else if (n_rows == 1) {
+                glDrawArrays(GL_TRIANGLE_STRIP,
+                             draw_state->row_firsts[y],
+                             draw_state->row_counts[y]);
+        } else {
+                for (i = 0; i < draw_state->overdraw; i++) {
+                        glMultiDrawArrays(GL_TRIANGLE_STRIP,
+                                          draw_state->row_firsts + y,
+                                          draw_state->row_counts + y,
+                                          n_rows);
+                }
+        }
+
+        if (draw_state->gpu_timer)
+                mct_gpu_timer_end_batch(draw_state->gpu_timer);
+}
+
+void
+mct_draw_state_end(struct mct_draw_state *draw_state)
+{
+        if (draw_state->gpu_timer)
+                mct_gpu_timer_begin_batch(draw_state->gpu_timer);
+
+        if (draw_state->stream) {
+                mct_stream_end(draw_state->stream,
+                               draw_state->stream_write_time);
+        }
+
+        glUseProgram(0);
+        glBindVertexArray(0);
+
+        if (draw_state->noise_texture)
+                glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (draw_state->uniform_buffer)
+                glBindBufferBase(GL_UNIFORM_BUFFER, 0, 0);
+
+        if (draw_state->readback)
+                mct_readback_queue(draw_state->readback, draw_state->band);
+
+        if (draw_state->fbo)
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (draw_state->gpu_timer) {
+                mct_gpu_timer_end_batch(draw_state->gpu_timer);
+                mct_gpu_timer_end(draw_state->gpu_timer);
+        }
+}
+
+const struct mct_gpu_timings *
+mct_draw_state_get_gpu_timings(struct mct_draw_state *draw_state)
+{
+        if (draw_state->gpu_timer == NULL)
+                return NULL;
+
+        return mct_gpu_timer_get_timings(draw_state->gpu_timer);
+}
+
+size_t
+mct_draw_state_get_grid_buffer_size(struct mct_draw_state *draw_state)
+{
+        return draw_state->grid_buffer_size;
+}
+
+size_t
+mct_draw_state_get_frame_vertex_bytes(struct mct_draw_state *draw_state)
+{
+        return draw_state->frame_vertex_bytes;
+}
+
+const struct mct_stream_stats *
+mct_draw_state_get_stream_stats(struct mct_draw_state *draw_state)
+{
+        if (draw_state->stream == NULL)
+                return NULL;
+
+        return mct_stream_get_stats(draw_state->stream);
+}
+
+const struct mct_memory_usage *
+mct_draw_state_get_grid_memory(struct mct_draw_state *draw_state)
+{
+        return &draw_state->grid_memory;
+}
+
+const struct mct_readback_stats *
+mct_draw_state_get_readback_stats(struct mct_draw_state *draw_state)
+{
+        if (draw_state->readback == NULL)
+                return NULL;
+
+        return mct_readback_get_stats(draw_state->readback);
+}
+
+void
+mct_draw_state_free(struct mct_draw_state *draw_state)
+{
+        if (draw_state->gpu_timer)
+                mct_gpu_timer_free(draw_state->gpu_timer);
+
+        if (draw_state->pending_prog) {
+                draw_state->prog =
+                        shader_data_finish_program(draw_state->pending_prog);
+        }
+
+        glDeleteVertexArrays(1, &draw_state->grid_array);
+
+        if (draw_state->stream)
+                mct_stream_free(draw_state->stream);
+
+        if (draw_state->readback)
+                mct_readback_free(draw_state->readback);
+
+        if (draw_state->fbo) {
+                glDeleteFramebuffers(1, &draw_state->fbo);
+                glDeleteRenderbuffers(1, &draw_state->color_buffer);
+        }
+
+        /* A separate uniform buffer belongs to each context */
+        if (draw_state->uniforms == MCT_UNIFORMS_UBO)
+                glDeleteBuffers(1, &draw_state->uniform_buffer);
+
+        if (draw_state->owns_shared_objects) {
+                if (draw_state->uniforms == MCT_UNIFORMS_SHARED_UBO)
+                        glDeleteBuffers(1, &draw_state->uniform_buffer);
+                glDeleteBuffers(1, &draw_state->grid_buffer);
+                glDeleteTextures(1, &draw_state->noise_texture);
+                glDeleteProgram(draw_state->prog);
+        }
+
+        free(draw_state->row_firsts);
+        free(draw_state->row_counts);
+
+        free(draw_state);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * Authors:
+ *    Neil Roberts <neil@linux.intel.com>
+ *
+ */
+
+
+#ifndef MCT_DRAW_STATE_H
+#define MCT_DRAW_STATE_H
+
+#include "mct-config.h"
+#include "mct-gpu-timer.h"
+#include "mct-stream.h"
+#include "mct-readback.h"
+#include "mct-memory.h"
+
+struct mct_draw_state;
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* If share_state is not NULL then the new draw state reuses its
+ * vertex buffer and program. The contexts must be in the same share
+ * group, share_state must already be finished and it must be freed
+ * last. The program is only submitted for compiling so
+ * mct_draw_state_finish must be called before drawing. */
+struct mct_draw_state *
+mct_draw_state_new(const struct mct_config *config,
+                   struct mct_draw_state *share_state);
+
+/* Whether mct_draw_state_finish can be called without blocking */
+bool
+mct_draw_state_is_ready(struct mct_draw_state *draw_state);
+
+/* Waits for the program to be compiled. Returns false if it failed,
+ * in which case the draw state should be freed. */
+bool
+mct_draw_state_finish(struct mct_draw_state *draw_state);
+
+/* Binds the framebuffer and program. When verifying, each frame uses
+ * the next of a fixed set of band positions and mct_draw_state_end
+ * queues the frame to be read back and compared. */
+void
+mct_draw_state_start(struct mct_draw_state *draw_state);
+
+/* Draws n_rows consecutive rows starting from y. More than one row
+ * is drawn with a single glMultiDrawArrays call. */
+void
+mct_draw_state_draw_rows(struct mct_draw_state *draw_state,
+                         int y,
+                         int n_rows);
+
+void
+mct_draw_state_end(struct mct_draw_state *draw_state);
+
+/* Size of the vertex buffer created by this draw state. This is zero
+ * if the buffer is shared from another draw state */
+size_t
+mct_draw_state_get_grid_buffer_size(struct mct_draw_state *draw_state);
+
+/* Size of the vertex data read from the buffer to draw the whole
+ * grid once. This is zero for the procedural grid */
+size_t
+mct_draw_state_get_frame_vertex_bytes(struct mct_draw_state *draw_state);
+
+/* Returns NULL if GPU timing isn't enabled in the config */
+const struct mct_gpu_timings *
+mct_draw_state_get_gpu_timings(struct mct_draw_state *draw_state);
+
+/* Returns NULL unless the grid is streamed */
+const struct mct_stream_stats *
+mct_draw_state_get_stream_stats(struct mct_draw_state *draw_state);
+
+/* Memory used to make the grid buffer. The count is zero unless
+ * memory sampling is enabled in the config and this draw state made
+ * its own buffer. */
+const struct mct_memory_usage *
+mct_draw_state_get_grid_memory(struct mct_draw_state *draw_state);
+
+/* Returns NULL unless verification is enabled */
+const struct mct_readback_stats *
+mct_draw_state_get_readback_stats(struct mct_draw_state *draw_state);
+
+void
+mct_draw_state_free(struct mct_draw_state *draw_state);
+
+#endif /* MCT_DRAW_STATE_H */
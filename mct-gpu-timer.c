@@ -0,0 +1,263 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "mct-gpu-timer.h"
+
+#define RING_SIZE 4
+
+struct mct_gpu_timer_slot {
+        GLuint timestamp_query;
+        /* One elapsed query for each batch. The array only grows so
+         * that a steady frame doesn't create any queries. */
+        GLuint *elapsed_queries;
+        int n_elapsed_queries;
+        int n_batches;
+        uint64_t cpu_start;
+        uint64_t cpu_time;
+        bool pending;
+};
+
+struct mct_gpu_timer {
+        /* Difference between GL_TIMESTAMP and mct_get_time_ns */
+        int64_t clock_offset;
+
+        /* Slot that is used for the current frame or NULL if the
+         * frame isn't being measured */
+        struct mct_gpu_timer_slot *active_slot;
+        int next_slot;
+
+        uint64_t batch_start;
+
+        struct mct_gpu_timer_slot slots[RING_SIZE];
+
+        struct mct_gpu_timings timings;
+};
+
+static int64_t
+get_clock_offset(void)
+{
+        GLint64 gpu_time;
+        uint64_t cpu_time;
+
+        /* GL_TIMESTAMP is the time at which the query reaches the
+         * GPU so make sure there is nothing in the way */
+        glFinish();
+
+        cpu_time = mct_get_time_ns();
+        glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+
+        return gpu_time - (int64_t) cpu_time;
+}
+
+struct mct_gpu_timer *
+mct_gpu_timer_new(void)
+{
+        struct mct_gpu_timer *timer = malloc(sizeof *timer);
+        int i;
+
+        for (i = 0; i < RING_SIZE; i++) {
+                glGenQueries(1, &timer->slots[i].timestamp_query);
+                timer->slots[i].elapsed_queries = NULL;
+                timer->slots[i].n_elapsed_queries = 0;
+                timer->slots[i].n_batches = 0;
+                timer->slots[i].pending = false;
+        }
+
+        timer->active_slot = NULL;
+        timer->next_slot = 0;
+
+        mct_histogram_init(&timer->timings.cpu);
+        mct_histogram_init(&timer->timings.gpu);
+        mct_histogram_init(&timer->timings.latency);
+        timer->timings.dropped = 0;
+        timer->timings.discarded = 0;
+
+        timer->clock_offset = get_clock_offset();
+
+        return timer;
+}
+
+static bool
+collect_slot(struct mct_gpu_timer *timer,
+             struct mct_gpu_timer_slot *slot)
+{
+        GLuint available;
+        GLuint64 timestamp, batch_elapsed, elapsed = 0;
+        int64_t latency;
+        int i;
+
+        if (slot->n_batches > 0) {
+                glGetQueryObjectuiv(slot->elapsed_queries[slot->n_batches - 1],
+                                    GL_QUERY_RESULT_AVAILABLE,
+                                    &available);
+                if (!available)
+                        return false;
+        }
+
+        /* The timestamp and the other batches were queued before the
+         * last batch so they are available too */
+        glGetQueryObjectui64v(slot->timestamp_query,
+                              GL_QUERY_RESULT,
+                              &timestamp);
+
+        for (i = 0; i < slot->n_batches; i++) {
+                glGetQueryObjectui64v(slot->elapsed_queries[i],
+                                      GL_QUERY_RESULT,
+                                      &batch_elapsed);
+                elapsed += batch_elapsed;
+        }
+
+        slot->pending = false;
+
+        /* The commands can't have taken longer to execute than the
+         * time since they were submitted. Some drivers return garbage
+         * for the very first query so throw that away. */
+        if (elapsed > mct_get_time_ns() - slot->cpu_start) {
+                timer->timings.discarded++;
+                return true;
+        }
+
+        latency = (int64_t) timestamp - timer->clock_offset -
+                (int64_t) slot->cpu_start;
+
+        mct_histogram_add(&timer->timings.cpu, slot->cpu_time);
+        mct_histogram_add(&timer->timings.gpu, elapsed);
+        mct_histogram_add(&timer->timings.latency,
+                          latency > 0 ? latency : 0);
+
+        return true;
+}
+
+static void
+collect_results(struct mct_gpu_timer *timer)
+{
+        int i;
+
+        for (i = 0; i < RING_SIZE; i++) {
+                if (timer->slots[i].pending)
+                        collect_slot(timer, timer->slots + i);
+        }
+}
+
+void
+mct_gpu_timer_begin(struct mct_gpu_timer *timer)
+{
+        struct mct_gpu_timer_slot *slot;
+
+        collect_results(timer);
+
+        slot = timer->slots + timer->next_slot;
+
+        if (slot->pending) {
+                timer->timings.dropped++;
+                timer->active_slot = NULL;
+                return;
+        }
+
+        timer->next_slot = (timer->next_slot + 1) % RING_SIZE;
+        timer->active_slot = slot;
+
+        slot->cpu_start = mct_get_time_ns();
+        slot->cpu_time = 0;
+        slot->n_batches = 0;
+
+        glQueryCounter(slot->timestamp_query, GL_TIMESTAMP);
+}
+
+void
+mct_gpu_timer_begin_batch(struct mct_gpu_timer *timer)
+{
+        struct mct_gpu_timer_slot *slot = timer->active_slot;
+
+        if (slot == NULL)
+                return;
+
+        if (slot->n_batches >= slot->n_elapsed_queries) {
+                slot->elapsed_queries =
+                        realloc(slot->elapsed_queries,
+                                (slot->n_batches + 1) *
+                                sizeof slot->elapsed_queries[0]);
+                glGenQueries(1, slot->elapsed_queries + slot->n_batches);
+                slot->n_elapsed_queries = slot->n_batches + 1;
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED,
+                     slot->elapsed_queries[slot->n_batches]);
+
+        timer->batch_start = mct_get_time_ns();
+}
+
+void
+mct_gpu_timer_end_batch(struct mct_gpu_timer *timer)
+{
+        struct mct_gpu_timer_slot *slot = timer->active_slot;
+
+        if (slot == NULL)
+                return;
+
+        slot->cpu_time += mct_get_time_ns() - timer->batch_start;
+
+        glEndQuery(GL_TIME_ELAPSED);
+
+        slot->n_batches++;
+}
+
+void
+mct_gpu_timer_end(struct mct_gpu_timer *timer)
+{
+        if (timer->active_slot == NULL)
+                return;
+
+        timer->active_slot->pending = true;
+        timer->active_slot = NULL;
+}
+
+const struct mct_gpu_timings *
+mct_gpu_timer_get_timings(struct mct_gpu_timer *timer)
+{
+        collect_results(timer);
+
+        return &timer->timings;
+}
+
+void
+mct_gpu_timer_free(struct mct_gpu_timer *timer)
+{
+        int i;
+
+        for (i = 0; i < RING_SIZE; i++) {
+                glDeleteQueries(1, &timer->slots[i].timestamp_query);
+                glDeleteQueries(timer->slots[i].n_elapsed_queries,
+                                timer->slots[i].elapsed_queries);
+                free(timer->slots[i].elapsed_queries);
+        }
+
+        free(timer);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_GPU_TIMER_H
+#define MCT_GPU_TIMER_H
+
+#include <stdint.h>
+
+#include "mct-timing.h"
+
+/* Measures how long the GPU takes to execute a context's commands for
+ * each frame with ARB_timer_query. The GPU runs the commands of every
+ * context that is interleaved with this one in between the start and
+ * the end of the frame so each batch of commands that is submitted
+ * without a context switch gets its own elapsed query and the frame
+ * time is their sum. The queries are kept in a small ring and are
+ * only read back once the results are available so measuring never
+ * stalls the pipeline. If all of the queries in the ring are still in
+ * flight the frame is simply not measured. */
+
+struct mct_gpu_timer;
+
+struct mct_gpu_timings {
+        /* CPU time spent submitting the commands in nanoseconds */
+        struct mct_histogram cpu;
+        /* GPU time spent executing this context's own batches of
+         * the frame, excluding the work of any other context that
+         * ran in between */
+        struct mct_histogram gpu;
+        /* Time between submitting the start of the frame and the GPU
+         * starting to execute it */
+        struct mct_histogram latency;
+        /* Frames that weren't measured because no query was free */
+        uint64_t dropped;
+        /* Frames whose results were thrown away because they took
+         * longer on the GPU than the time since they were submitted,
+         * which some drivers report for the very first query */
+        uint64_t discarded;
+};
+
+/* These must all be called with the context current */
+
+struct mct_gpu_timer *
+mct_gpu_timer_new(void);
+
+void
+mct_gpu_timer_begin(struct mct_gpu_timer *timer);
+
+/* Brackets a batch of commands that is submitted without switching
+ * to another context. Only valid between begin and end. */
+void
+mct_gpu_timer_begin_batch(struct mct_gpu_timer *timer);
+
+void
+mct_gpu_timer_end_batch(struct mct_gpu_timer *timer);
+
+void
+mct_gpu_timer_end(struct mct_gpu_timer *timer);
+
+const struct mct_gpu_timings *
+mct_gpu_timer_get_timings(struct mct_gpu_timer *timer);
+
+void
+mct_gpu_timer_free(struct mct_gpu_timer *timer);
+
+#endif /* MCT_GPU_TIMER_H */
@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mct-memory.h"
+
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#endif
+#ifndef GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+long
+mct_memory_get_rss(void)
+{
+        FILE *file;
+        long size, resident;
+        int n_read;
+
+        file = fopen("/proc/self/statm", "r");
+        if (file == NULL)
+                return -1;
+
+        n_read = fscanf(file, "%li %li", &size, &resident);
+
+        fclose(file);
+
+        if (n_read != 2)
+                return -1;
+
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static bool
+read_rollup(long *rss,
+            long *pss)
+{
+        char line[256];
+        FILE *file;
+        long value;
+
+        file = fopen("/proc/self/smaps_rollup", "r");
+        if (file == NULL)
+                return false;
+
+        *rss = -1;
+        *pss = -1;
+
+        while (fgets(line, sizeof line, file)) {
+                if (sscanf(line, "Rss: %li kB", &value) == 1)
+                        *rss = value;
+                else if (sscanf(line, "Pss: %li kB", &value) == 1)
+                        *pss = value;
+        }
+
+        fclose(file);
+
+        return *rss >= 0;
+}
+
+static long
+get_gpu_free(void)
+{
+        GLint values[4];
+
+        if (epoxy_has_gl_extension("GL_NVX_gpu_memory_info")) {
+                glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX,
+                              values);
+                return values[0];
+        }
+
+        /* The first value is the total free memory in the pool */
+        if (epoxy_has_gl_extension("GL_ATI_meminfo")) {
+                glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, values);
+                return values[0];
+        }
+
+        return -1;
+}
+
+void
+mct_memory_sample(struct mct_memory_sample *sample,
+                  bool gpu)
+{
+        /* smaps_rollup needs Linux 4.14 */
+        if (!read_rollup(&sample->rss, &sample->pss)) {
+                sample->rss = mct_memory_get_rss();
+                sample->pss = -1;
+        }
+
+        sample->gpu_free = gpu ? get_gpu_free() : -1;
+}
+
+long
+mct_memory_get_gpu_total(void)
+{
+        GLint value;
+
+        if (!epoxy_has_gl_extension("GL_NVX_gpu_memory_info"))
+                return -1;
+
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &value);
+
+        return value;
+}
+
+void
+mct_memory_usage_init(struct mct_memory_usage *usage)
+{
+        memset(usage, 0, sizeof *usage);
+}
+
+static void
+add_size(long *total,
+         long value)
+{
+        if (*total == MCT_MEMORY_UNKNOWN || value == MCT_MEMORY_UNKNOWN)
+                *total = MCT_MEMORY_UNKNOWN;
+        else
+                *total += value;
+}
+
+static long
+get_growth(long start,
+           long end)
+{
+        if (start < 0 || end < 0)
+                return MCT_MEMORY_UNKNOWN;
+
+        return end - start;
+}
+
+void
+mct_memory_usage_add(struct mct_memory_usage *usage,
+                     const struct mct_memory_sample *start,
+                     const struct mct_memory_sample *end,
+                     int count)
+{
+        usage->count += count;
+        add_size(&usage->rss, get_growth(start->rss, end->rss));
+        add_size(&usage->pss, get_growth(start->pss, end->pss));
+
+        if (start->gpu_free >= 0 && end->gpu_free >= 0) {
+                usage->gpu_count += count;
+                usage->gpu += start->gpu_free - end->gpu_free;
+        }
+}
+
+void
+mct_memory_usage_merge(struct mct_memory_usage *usage,
+                       const struct mct_memory_usage *other)
+{
+        usage->count += other->count;
+        add_size(&usage->rss, other->rss);
+        add_size(&usage->pss, other->pss);
+        usage->gpu_count += other->gpu_count;
+        usage->gpu += other->gpu;
+}
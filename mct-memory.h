@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_MEMORY_H
+#define MCT_MEMORY_H
+
+#include <stdbool.h>
+#include <limits.h>
+
+/* All of the sizes are in kilobytes. The sizes in a sample are -1 if
+ * they can't be determined. The growth can be negative so unknown
+ * values in a usage are MCT_MEMORY_UNKNOWN instead. */
+
+#define MCT_MEMORY_UNKNOWN LONG_MIN
+
+struct mct_memory_sample {
+        long rss;
+        /* Proportional set size, which splits shared pages between
+         * the processes that map them */
+        long pss;
+        /* Free video memory reported by GL_NVX_gpu_memory_info or
+         * GL_ATI_meminfo */
+        long gpu_free;
+};
+
+/* Growth of the memory over some number of objects, such as the
+ * contexts that were created. gpu is the drop in free video memory,
+ * which is only known for gpu_count of the objects because it can't
+ * be sampled before the first context exists. */
+struct mct_memory_usage {
+        int count;
+        long rss;
+        long pss;
+        int gpu_count;
+        long gpu;
+};
+
+/* Returns the resident set size of the process in kilobytes or -1 if
+ * it can't be determined */
+long
+mct_memory_get_rss(void);
+
+/* The GPU memory can only be sampled with a current context. If gpu
+ * is false it is left as -1. The RSS and PSS come from
+ * /proc/self/smaps_rollup, which is slow enough that this shouldn't
+ * be called while measuring anything else. */
+void
+mct_memory_sample(struct mct_memory_sample *sample,
+                  bool gpu);
+
+/* Total video memory reported by GL_NVX_gpu_memory_info for the
+ * current context or -1 */
+long
+mct_memory_get_gpu_total(void);
+
+void
+mct_memory_usage_init(struct mct_memory_usage *usage);
+
+/* Adds the difference between the samples as count objects. An
+ * unknown RSS or PSS in either sample makes the total unknown but an
+ * unknown GPU size is only left out. */
+void
+mct_memory_usage_add(struct mct_memory_usage *usage,
+                     const struct mct_memory_sample *start,
+                     const struct mct_memory_sample *end,
+                     int count);
+
+void
+mct_memory_usage_merge(struct mct_memory_usage *usage,
+                       const struct mct_memory_usage *other);
+
+#endif /* MCT_MEMORY_H */
@@ -0,0 +1,251 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#endif
+
+#include "mct-perf.h"
+
+const char *const
+mct_perf_counter_names[MCT_PERF_N_COUNTERS] = {
+        [MCT_PERF_CYCLES] = "cycles",
+        [MCT_PERF_INSTRUCTIONS] = "instructions",
+        [MCT_PERF_CACHE_MISSES] = "cache_misses",
+        [MCT_PERF_CONTEXT_SWITCHES] = "context_switches",
+};
+
+struct mct_perf {
+        int group_fd;
+        int fds[MCT_PERF_N_COUNTERS];
+
+        /* Position of each counter in the group read or -1 if it
+         * isn't open */
+        int indices[MCT_PERF_N_COUNTERS];
+        int n_open;
+};
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+
+static const struct {
+        uint32_t type;
+        uint64_t config;
+} counter_events[MCT_PERF_N_COUNTERS] = {
+        [MCT_PERF_CYCLES] = {
+                PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES
+        },
+        [MCT_PERF_INSTRUCTIONS] = {
+                PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS
+        },
+        [MCT_PERF_CACHE_MISSES] = {
+                PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES
+        },
+        [MCT_PERF_CONTEXT_SWITCHES] = {
+                PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES
+        },
+};
+
+static int
+open_counter(enum mct_perf_counter counter,
+             int group_fd,
+             bool exclude_kernel)
+{
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = counter_events[counter].type;
+        attr.config = counter_events[counter].config;
+        attr.read_format = (PERF_FORMAT_GROUP |
+                            PERF_FORMAT_TOTAL_TIME_ENABLED |
+                            PERF_FORMAT_TOTAL_TIME_RUNNING);
+        attr.disabled = group_fd == -1;
+        attr.exclude_kernel = exclude_kernel;
+        attr.exclude_hv = true;
+
+        /* pid 0 and cpu -1 follows the calling thread on any CPU */
+        return syscall(SYS_perf_event_open,
+                       &attr,
+                       0, /* pid */
+                       -1, /* cpu */
+                       group_fd,
+                       0 /* flags */);
+}
+
+struct mct_perf *
+mct_perf_new(void)
+{
+        struct mct_perf *perf = malloc(sizeof *perf);
+        bool exclude_kernel = false;
+        int i, fd;
+
+        perf->group_fd = -1;
+        perf->n_open = 0;
+
+        for (i = 0; i < MCT_PERF_N_COUNTERS; i++) {
+                fd = open_counter(i, perf->group_fd, exclude_kernel);
+
+                /* An unprivileged process might only be allowed to
+                 * count user space */
+                if (fd == -1 && errno == EACCES && !exclude_kernel) {
+                        exclude_kernel = true;
+                        fd = open_counter(i, perf->group_fd, exclude_kernel);
+                }
+
+                perf->fds[i] = fd;
+
+                if (fd == -1) {
+                        perf->indices[i] = -1;
+                        continue;
+                }
+
+                if (perf->group_fd == -1)
+                        perf->group_fd = fd;
+
+                perf->indices[i] = perf->n_open++;
+        }
+
+        if (perf->group_fd == -1) {
+                free(perf);
+                return NULL;
+        }
+
+        ioctl(perf->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(perf->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+        return perf;
+}
+
+void
+mct_perf_read(struct mct_perf *perf,
+              struct mct_perf_values *values)
+{
+        uint64_t buf[MCT_PERF_N_COUNTERS + 3];
+        uint64_t enabled, running;
+        int i;
+
+        /* The group read format is the number of counters, the time
+         * the group was enabled and the time it was actually on the
+         * PMU followed by each value */
+        if (read(perf->group_fd, buf, sizeof buf) <
+            (ssize_t) (sizeof buf[0] * (perf->n_open + 3)) ||
+            buf[2] == 0) {
+                memset(values, 0, sizeof *values);
+                return;
+        }
+
+        enabled = buf[1];
+        running = buf[2];
+
+        for (i = 0; i < MCT_PERF_N_COUNTERS; i++) {
+                if (perf->indices[i] == -1) {
+                        values->values[i] = 0;
+                        continue;
+                }
+
+                values->values[i] = buf[perf->indices[i] + 3];
+
+                /* If there are more counters than the PMU can hold
+                 * the group is multiplexed and only counted part of
+                 * the time so scale it up to an estimate */
+                if (running < enabled) {
+                        values->values[i] = (values->values[i] *
+                                             (double) enabled /
+                                             running);
+                }
+        }
+}
+
+void
+mct_perf_free(struct mct_perf *perf)
+{
+        int i;
+
+        for (i = MCT_PERF_N_COUNTERS - 1; i >= 0; i--) {
+                if (perf->fds[i] != -1)
+                        close(perf->fds[i]);
+        }
+
+        free(perf);
+}
+
+#else /* HAVE_LINUX_PERF_EVENT_H */
+
+struct mct_perf *
+mct_perf_new(void)
+{
+        return NULL;
+}
+
+void
+mct_perf_read(struct mct_perf *perf,
+              struct mct_perf_values *values)
+{
+        memset(values, 0, sizeof *values);
+}
+
+void
+mct_perf_free(struct mct_perf *perf)
+{
+        free(perf);
+}
+
+#endif /* HAVE_LINUX_PERF_EVENT_H */
+
+bool
+mct_perf_has_counter(const struct mct_perf *perf,
+                     enum mct_perf_counter counter)
+{
+        return perf->indices[counter] != -1;
+}
+
+void
+mct_perf_values_add_delta(struct mct_perf_values *total,
+                          const struct mct_perf_values *start,
+                          const struct mct_perf_values *end)
+{
+        int i;
+
+        for (i = 0; i < MCT_PERF_N_COUNTERS; i++)
+                total->values[i] += end->values[i] - start->values[i];
+}
+
+void
+mct_perf_values_add(struct mct_perf_values *total,
+                    const struct mct_perf_values *values)
+{
+        int i;
+
+        for (i = 0; i < MCT_PERF_N_COUNTERS; i++)
+                total->values[i] += values->values[i];
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_PERF_H
+#define MCT_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* CPU performance counters for the calling thread read with
+ * perf_event_open. All of the counters are opened as one group so
+ * that reading them is a single system call. Counters that the
+ * kernel or the hardware doesn't allow are left out. Only the calling
+ * thread is counted, so any work done on the driver's own threads,
+ * such as a shader compiler or llvmpipe's rasterizer threads, is
+ * missing. If the group is multiplexed with other events the values
+ * are scaled up to estimates from the fraction of the time it was
+ * running. */
+
+enum mct_perf_counter {
+        MCT_PERF_CYCLES,
+        MCT_PERF_INSTRUCTIONS,
+        MCT_PERF_CACHE_MISSES,
+        MCT_PERF_CONTEXT_SWITCHES,
+};
+
+#define MCT_PERF_N_COUNTERS (MCT_PERF_CONTEXT_SWITCHES + 1)
+
+struct mct_perf_values {
+        uint64_t values[MCT_PERF_N_COUNTERS];
+};
+
+struct mct_perf;
+
+extern const char *const
+mct_perf_counter_names[MCT_PERF_N_COUNTERS];
+
+/* Opens the counters for the calling thread. Returns NULL if none of
+ * them could be opened. */
+struct mct_perf *
+mct_perf_new(void);
+
+bool
+mct_perf_has_counter(const struct mct_perf *perf,
+                     enum mct_perf_counter counter);
+
+/* Reads the current values. Missing counters read as zero. */
+void
+mct_perf_read(struct mct_perf *perf,
+              struct mct_perf_values *values);
+
+/* Adds end - start to total */
+void
+mct_perf_values_add_delta(struct mct_perf_values *total,
+                          const struct mct_perf_values *start,
+                          const struct mct_perf_values *end);
+
+void
+mct_perf_values_add(struct mct_perf_values *total,
+                    const struct mct_perf_values *values);
+
+void
+mct_perf_free(struct mct_perf *perf);
+
+#endif /* MCT_PERF_H */
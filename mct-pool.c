@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mct-pool.h"
+#include "mct-memory.h"
+
+struct mct_pool_slot {
+        struct mct_window *window;
+        int tenant;
+        /* Value of the pool's use counter when the tenant last
+         * acquired the context */
+        uint64_t last_use;
+};
+
+struct mct_pool {
+        struct mct_display *display;
+        int width, height;
+        bool flush_on_release;
+        bool surfaceless;
+
+        int max_contexts;
+        int n_slots;
+        struct mct_pool_slot *slots;
+        /* Index of each tenant's slot or -1 */
+        int *tenant_slots;
+        uint64_t use_count;
+
+        long initial_rss;
+        struct mct_pool_stats stats;
+};
+
+struct mct_pool *
+mct_pool_new(struct mct_display *display,
+             int width, int height,
+             bool flush_on_release,
+             bool surfaceless,
+             int n_tenants,
+             int max_contexts)
+{
+        struct mct_pool *pool = malloc(sizeof *pool);
+        int i;
+
+        if (max_contexts <= 0 || max_contexts > n_tenants)
+                max_contexts = n_tenants;
+
+        pool->display = display;
+        pool->width = width;
+        pool->height = height;
+        pool->flush_on_release = flush_on_release;
+        pool->surfaceless = surfaceless;
+
+        pool->max_contexts = max_contexts;
+        pool->n_slots = 0;
+        pool->slots = malloc(sizeof *pool->slots * max_contexts);
+        pool->tenant_slots = malloc(sizeof *pool->tenant_slots * n_tenants);
+        for (i = 0; i < n_tenants; i++)
+                pool->tenant_slots[i] = -1;
+        pool->use_count = 0;
+
+        pool->initial_rss = mct_memory_get_rss();
+        memset(&pool->stats, 0, sizeof pool->stats);
+        mct_histogram_init(&pool->stats.create_time);
+
+        return pool;
+}
+
+static struct mct_pool_slot *
+create_slot(struct mct_pool *pool)
+{
+        struct mct_pool_slot *slot = pool->slots + pool->n_slots;
+        uint64_t start_time;
+        long start_rss;
+
+        start_rss = mct_memory_get_rss();
+        start_time = mct_get_time_ns();
+
+        slot->window = mct_window_new(pool->display,
+                                      pool->width, pool->height,
+                                      pool->flush_on_release,
+                                      pool->surfaceless,
+                                      NULL /* share_window */);
+
+        if (slot->window == NULL)
+                return NULL;
+
+        mct_window_show(slot->window);
+
+        mct_histogram_add(&pool->stats.create_time,
+                          mct_get_time_ns() - start_time);
+        pool->stats.create_rss += mct_memory_get_rss() - start_rss;
+        pool->stats.created++;
+        pool->n_slots++;
+
+        return slot;
+}
+
+static struct mct_pool_slot *
+recycle_slot(struct mct_pool *pool)
+{
+        struct mct_pool_slot *slot = pool->slots;
+        int i;
+
+        /* The pool is small enough that a linear search is cheaper
+         * than the context switches around it */
+        for (i = 1; i < pool->n_slots; i++) {
+                if (pool->slots[i].last_use < slot->last_use)
+                        slot = pool->slots + i;
+        }
+
+        pool->tenant_slots[slot->tenant] = -1;
+        pool->stats.recycled++;
+
+        return slot;
+}
+
+struct mct_window *
+mct_pool_acquire(struct mct_pool *pool,
+                 int tenant,
+                 int *evicted)
+{
+        struct mct_pool_slot *slot;
+
+        *evicted = -1;
+
+        if (pool->tenant_slots[tenant] >= 0) {
+                slot = pool->slots + pool->tenant_slots[tenant];
+        } else if (pool->n_slots < pool->max_contexts) {
+                slot = create_slot(pool);
+                if (slot == NULL)
+                        return NULL;
+        } else {
+                slot = recycle_slot(pool);
+                *evicted = slot->tenant;
+        }
+
+        slot->tenant = tenant;
+        slot->last_use = ++pool->use_count;
+        pool->tenant_slots[tenant] = slot - pool->slots;
+
+        return slot->window;
+}
+
+struct mct_window *
+mct_pool_get_window(struct mct_pool *pool,
+                    int tenant)
+{
+        if (pool->tenant_slots[tenant] < 0)
+                return NULL;
+
+        return pool->slots[pool->tenant_slots[tenant]].window;
+}
+
+void
+mct_pool_get_stats(struct mct_pool *pool,
+                   struct mct_pool_stats *stats)
+{
+        *stats = pool->stats;
+        stats->total_rss = mct_memory_get_rss() - pool->initial_rss;
+        stats->n_contexts = pool->n_slots;
+}
+
+void
+mct_pool_free(struct mct_pool *pool)
+{
+        int i;
+
+        for (i = pool->n_slots - 1; i >= 0; i--)
+                mct_window_free(pool->slots[i].window);
+
+        free(pool->slots);
+        free(pool->tenant_slots);
+        free(pool);
+}
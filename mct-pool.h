@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MCT_POOL_H
+#define MCT_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mct-window.h"
+#include "mct-timing.h"
+
+/* A limited number of contexts that are handed out to a larger number
+ * of tenants. A tenant's context is only created the first time it
+ * is needed. Once the pool is full the context of the least recently
+ * used tenant is taken away and given to the next tenant that needs
+ * one, so the caller has to rebuild its state in it. */
+
+struct mct_pool;
+
+struct mct_pool_stats {
+        /* Contexts created for a tenant while the pool wasn't full */
+        uint64_t created;
+        /* Contexts taken from another tenant */
+        uint64_t recycled;
+        /* Time in nanoseconds to create each context */
+        struct mct_histogram create_time;
+        /* Growth of the resident set in kilobytes while creating the
+         * contexts */
+        long create_rss;
+        /* Growth of the resident set since the pool was created,
+         * which includes whatever the driver allocates later */
+        long total_rss;
+        /* Contexts that exist at the moment */
+        int n_contexts;
+};
+
+/* If max_contexts is zero every tenant can have its own context */
+struct mct_pool *
+mct_pool_new(struct mct_display *display,
+             int width, int height,
+             bool flush_on_release,
+             bool surfaceless,
+             int n_tenants,
+             int max_contexts);
+
+/* Returns the tenant's context, creating or recycling one if it
+ * doesn't have one. evicted is set to the tenant that the context
+ * was taken from or -1. Returns NULL if a context couldn't be
+ * created. */
+struct mct_window *
+mct_pool_acquire(struct mct_pool *pool,
+                 int tenant,
+                 int *evicted);
+
+/* The tenant's context or NULL if it doesn't have one */
+struct mct_window *
+mct_pool_get_window(struct mct_pool *pool,
+                    int tenant);
+
+void
+mct_pool_get_stats(struct mct_pool *pool,
+                   struct mct_pool_stats *stats);
+
+/* Destroys all of the contexts. Anything the tenants created in them
+ * has to be freed first. */
+void
+mct_pool_free(struct mct_pool *pool);
+
+#endif /* MCT_POOL_H */
@@ -0,0 +1,243 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "mct-process.h"
+
+/* Stored at the start of the shared memory so that a worker can find
+ * out how much to map */
+struct mct_process_header {
+        size_t size;
+};
+
+#define HEADER_SIZE \
+        ((sizeof (struct mct_process_header) + 63) & ~(size_t) 63)
+
+struct mct_process_group {
+        int fd;
+        size_t size;
+        struct mct_process_header *header;
+
+        int n_workers;
+        pid_t *pids;
+};
+
+struct mct_process_group *
+mct_process_group_new(size_t shared_size)
+{
+        struct mct_process_group *group;
+        size_t size = HEADER_SIZE + shared_size;
+        FILE *file;
+        void *map;
+        int fd;
+
+        /* An unlinked temporary file survives the exec in the workers
+         * as long as the descriptor isn't closed on exec */
+        file = tmpfile();
+        if (file == NULL) {
+                fprintf(stderr, "Failed to create shared memory: %m\n");
+                return NULL;
+        }
+
+        fd = dup(fileno(file));
+        fclose(file);
+
+        if (fd == -1 ||
+            fcntl(fd, F_SETFD, 0) == -1 ||
+            ftruncate(fd, size) == -1) {
+                fprintf(stderr, "Failed to create shared memory: %m\n");
+                if (fd != -1)
+                        close(fd);
+                return NULL;
+        }
+
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+                fprintf(stderr, "Failed to map shared memory: %m\n");
+                close(fd);
+                return NULL;
+        }
+
+        group = malloc(sizeof *group);
+        group->fd = fd;
+        group->size = size;
+        group->header = map;
+        group->header->size = size;
+        group->n_workers = 0;
+        group->pids = NULL;
+
+        return group;
+}
+
+void *
+mct_process_group_get_shared(struct mct_process_group *group)
+{
+        return (uint8_t *) group->header + HEADER_SIZE;
+}
+
+bool
+mct_process_group_start(struct mct_process_group *group,
+                        const char *option,
+                        int n_workers)
+{
+        char arg[128];
+        pid_t pid;
+        int i;
+
+        /* Anything buffered would otherwise be written again by each
+         * child if the exec fails */
+        fflush(stdout);
+        fflush(stderr);
+
+        group->pids = malloc(sizeof *group->pids * n_workers);
+
+        for (i = 0; i < n_workers; i++) {
+                snprintf(arg, sizeof arg, "--%s=%i,%i", option, group->fd, i);
+
+                pid = fork();
+
+                if (pid == -1) {
+                        fprintf(stderr, "fork failed: %m\n");
+                        return false;
+                }
+
+                if (pid == 0) {
+                        execl("/proc/self/exe",
+                              "multi-context-test",
+                              arg,
+                              (char *) NULL);
+                        fprintf(stderr, "Failed to run a worker: %m\n");
+                        _exit(EXIT_FAILURE);
+                }
+
+                group->pids[group->n_workers++] = pid;
+        }
+
+        return true;
+}
+
+bool
+mct_process_group_has_exited(struct mct_process_group *group)
+{
+        siginfo_t info;
+        int i;
+
+        for (i = 0; i < group->n_workers; i++) {
+                /* WNOWAIT leaves the child to be reaped later */
+                info.si_pid = 0;
+                if (waitid(P_PID,
+                           group->pids[i],
+                           &info,
+                           WEXITED | WNOHANG | WNOWAIT) == 0 &&
+                    info.si_pid != 0)
+                        return true;
+        }
+
+        return false;
+}
+
+bool
+mct_process_group_wait(struct mct_process_group *group)
+{
+        bool ret = true;
+        int i, status;
+
+        for (i = 0; i < group->n_workers; i++) {
+                if (waitpid(group->pids[i], &status, 0) == -1 ||
+                    !WIFEXITED(status) ||
+                    WEXITSTATUS(status) != EXIT_SUCCESS) {
+                        fprintf(stderr, "Worker process %i failed\n", i);
+                        ret = false;
+                }
+        }
+
+        group->n_workers = 0;
+
+        return ret;
+}
+
+void
+mct_process_group_free(struct mct_process_group *group)
+{
+        munmap(group->header, group->size);
+        close(group->fd);
+        free(group->pids);
+        free(group);
+}
+
+void *
+mct_process_worker_map(const char *value,
+                       int *index)
+{
+        struct mct_process_header *header;
+        size_t size;
+        int fd;
+
+        if (sscanf(value, "%i,%i", &fd, index) != 2) {
+                fprintf(stderr, "Invalid worker argument\n");
+                return NULL;
+        }
+
+        header = mmap(NULL, sizeof *header, PROT_READ, MAP_SHARED, fd, 0);
+        if (header == MAP_FAILED) {
+                fprintf(stderr, "Failed to map shared memory: %m\n");
+                return NULL;
+        }
+
+        size = header->size;
+        munmap(header, sizeof *header);
+
+        header = mmap(NULL,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED,
+                      fd,
+                      0);
+        close(fd);
+
+        if (header == MAP_FAILED) {
+                fprintf(stderr, "Failed to map shared memory: %m\n");
+                return NULL;
+        }
+
+        return (uint8_t *) header + HEADER_SIZE;
+}
+
+void
+mct_process_worker_unmap(void *shared)
+{
+        struct mct_process_header *header =
+                (void *) ((uint8_t *) shared - HEADER_SIZE);
+
+        munmap(header, header->size);
+}
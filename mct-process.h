@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MCT_PROCESS_H
+#define MCT_PROCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A group of worker processes that share a block of memory with the
+ * main process. The workers are started by running this program
+ * again with an extra option so that none of the window system state
+ * of the main process is inherited. The option's value tells the
+ * worker where to find the shared memory and its index. */
+
+struct mct_process_group;
+
+/* Creates the zero-filled shared memory. Returns NULL on failure. */
+struct mct_process_group *
+mct_process_group_new(size_t shared_size);
+
+void *
+mct_process_group_get_shared(struct mct_process_group *group);
+
+/* Starts n_workers copies of this program with
+ * --<option>=<value> as their only argument */
+bool
+mct_process_group_start(struct mct_process_group *group,
+                        const char *option,
+                        int n_workers);
+
+/* Returns true if any of the workers has exited without being
+ * waited for */
+bool
+mct_process_group_has_exited(struct mct_process_group *group);
+
+/* Waits for all of the workers. Returns false if any of them failed. */
+bool
+mct_process_group_wait(struct mct_process_group *group);
+
+void
+mct_process_group_free(struct mct_process_group *group);
+
+/* Maps the shared memory in a worker given the option's value.
+ * Returns NULL on failure. */
+void *
+mct_process_worker_map(const char *value,
+                       int *index);
+
+void
+mct_process_worker_unmap(void *shared);
+
+#endif /* MCT_PROCESS_H */
@@ -0,0 +1,237 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mct-readback.h"
+#include "mct-timing.h"
+
+/* Number of frames between queuing a read and mapping it */
+#define N_BUFFERS 3
+
+struct mct_readback_buffer {
+        GLuint buffer;
+        /* NULL if there is no read pending in the buffer */
+        GLsync fence;
+        int tag;
+};
+
+struct mct_readback {
+        int width;
+        int height;
+        size_t size;
+        const uint64_t *reference;
+
+        int next_buffer;
+        struct mct_readback_buffer buffers[N_BUFFERS];
+
+        struct mct_readback_stats stats;
+};
+
+static uint64_t
+hash_pixels(const void *data,
+            size_t size)
+{
+        const uint64_t *p = data;
+        uint64_t hash = UINT64_C(0xcbf29ce484222325);
+        size_t i;
+
+        /* FNV-1a over 64-bit words instead of bytes so that hashing
+         * a frame is cheap compared to drawing it. The size is always
+         * a multiple of 4 so the last word may be partial. */
+        for (i = 0; i < size / sizeof *p; i++) {
+                hash ^= p[i];
+                hash *= UINT64_C(0x100000001b3);
+        }
+
+        if (size % sizeof *p) {
+                uint64_t last = 0;
+
+                memcpy(&last, p + i, size % sizeof *p);
+                hash ^= last;
+                hash *= UINT64_C(0x100000001b3);
+        }
+
+        return hash;
+}
+
+static void
+read_pixels(int width,
+            int height,
+            void *data)
+{
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0,
+                     width, height,
+                     GL_RGBA, GL_UNSIGNED_BYTE,
+                     data);
+}
+
+uint64_t
+mct_readback_hash_now(int width,
+                      int height)
+{
+        size_t size = (size_t) width * height * 4;
+        void *data = malloc(size);
+        uint64_t hash;
+
+        read_pixels(width, height, data);
+        hash = hash_pixels(data, size);
+
+        free(data);
+
+        return hash;
+}
+
+struct mct_readback *
+mct_readback_new(int width,
+                 int height,
+                 const uint64_t *reference)
+{
+        struct mct_readback *readback = malloc(sizeof *readback);
+        int i;
+
+        readback->width = width;
+        readback->height = height;
+        readback->size = (size_t) width * height * 4;
+        readback->reference = reference;
+        readback->next_buffer = 0;
+        memset(&readback->stats, 0, sizeof readback->stats);
+
+        for (i = 0; i < N_BUFFERS; i++) {
+                glGenBuffers(1, &readback->buffers[i].buffer);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER,
+                             readback->buffers[i].buffer);
+                glBufferData(GL_PIXEL_PACK_BUFFER,
+                             readback->size,
+                             NULL,
+                             GL_STREAM_READ);
+                readback->buffers[i].fence = NULL;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        return readback;
+}
+
+static void
+check_buffer(struct mct_readback *readback,
+             struct mct_readback_buffer *buffer)
+{
+        uint64_t start_time, hash;
+        void *data;
+
+        if (glClientWaitSync(buffer->fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                /* The fence might not have been flushed yet if the
+                 * release behavior is none */
+                start_time = mct_get_time_ns();
+                glClientWaitSync(buffer->fence,
+                                 GL_SYNC_FLUSH_COMMANDS_BIT,
+                                 UINT64_MAX);
+                readback->stats.wait_time += mct_get_time_ns() - start_time;
+        }
+
+        glDeleteSync(buffer->fence);
+        buffer->fence = NULL;
+
+        start_time = mct_get_time_ns();
+
+        data = glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                                0, readback->size,
+                                GL_MAP_READ_BIT);
+        hash = data ? hash_pixels(data, readback->size) : 0;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        readback->stats.hash_time += mct_get_time_ns() - start_time;
+
+        readback->stats.checked++;
+        if (data == NULL || hash != readback->reference[buffer->tag])
+                readback->stats.corrupt++;
+}
+
+void
+mct_readback_queue(struct mct_readback *readback,
+                   int tag)
+{
+        struct mct_readback_buffer *buffer =
+                readback->buffers + readback->next_buffer;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->buffer);
+
+        if (buffer->fence)
+                check_buffer(readback, buffer);
+
+        read_pixels(readback->width, readback->height, NULL);
+        buffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        buffer->tag = tag;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        readback->next_buffer = (readback->next_buffer + 1) % N_BUFFERS;
+}
+
+/* Checks the reads that are still in the ring, oldest first */
+static void
+check_pending(struct mct_readback *readback)
+{
+        struct mct_readback_buffer *buffer;
+        int i;
+
+        for (i = 0; i < N_BUFFERS; i++) {
+                buffer = readback->buffers +
+                        (readback->next_buffer + i) % N_BUFFERS;
+
+                if (buffer->fence == NULL)
+                        continue;
+
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->buffer);
+                check_buffer(readback, buffer);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+const struct mct_readback_stats *
+mct_readback_get_stats(struct mct_readback *readback)
+{
+        check_pending(readback);
+
+        return &readback->stats;
+}
+
+void
+mct_readback_free(struct mct_readback *readback)
+{
+        int i;
+
+        check_pending(readback);
+
+        for (i = 0; i < N_BUFFERS; i++)
+                glDeleteBuffers(1, &readback->buffers[i].buffer);
+
+        free(readback);
+}
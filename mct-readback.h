@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MCT_READBACK_H
+#define MCT_READBACK_H
+
+#include <epoxy/gl.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Reads back every frame through a ring of pixel buffer objects so
+ * that the CPU never waits for the frame it has just drawn. Each read
+ * is mapped a few frames later, hashed and compared with the hash of
+ * a reference render of the same frame. */
+
+struct mct_readback;
+
+struct mct_readback_stats {
+        /* Frames whose hash was compared */
+        uint64_t checked;
+        /* Frames that didn't match the reference */
+        uint64_t corrupt;
+        /* Time spent waiting for reads to finish */
+        uint64_t wait_time;
+        /* Time spent hashing the mapped pixels */
+        uint64_t hash_time;
+};
+
+/* These must all be called with the context current */
+
+/* Reads the current read framebuffer immediately and hashes it. This
+ * is meant for the reference renders. */
+uint64_t
+mct_readback_hash_now(int width,
+                      int height);
+
+/* reference is an array of hashes indexed by the tag given to
+ * mct_readback_queue. It must stay valid until the readback is
+ * freed. */
+struct mct_readback *
+mct_readback_new(int width,
+                 int height,
+                 const uint64_t *reference);
+
+/* Starts reading the current read framebuffer into the next buffer in
+ * the ring. Before that the previous read from the same buffer is
+ * checked against the reference hash for its tag. */
+void
+mct_readback_queue(struct mct_readback *readback,
+                   int tag);
+
+/* Waits for and checks any reads that are still in flight first so
+ * that the last frames are included */
+const struct mct_readback_stats *
+mct_readback_get_stats(struct mct_readback *readback);
+
+void
+mct_readback_free(struct mct_readback *readback);
+
+#endif /* MCT_READBACK_H */
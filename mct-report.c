@@ -0,0 +1,327 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include "mct-report.h"
+
+/* The arrays grow if a record has more fields than this */
+#define INITIAL_FIELDS 128
+#define MAX_KEY_LENGTH 48
+#define MAX_VALUE_LENGTH 64
+
+struct mct_report_field {
+        char key[MAX_KEY_LENGTH];
+        bool is_string;
+        char value[MAX_VALUE_LENGTH];
+};
+
+struct mct_report {
+        enum mct_report_format format;
+        FILE *out;
+
+        const char *record;
+        int n_fields;
+        int fields_size;
+        struct mct_report_field *fields;
+
+        /* Columns of the last CSV header that was written */
+        const char *header_record;
+        int n_header_keys;
+        int header_keys_size;
+        char (*header_keys)[MAX_KEY_LENGTH];
+};
+
+static const struct {
+        const char *name;
+        enum mct_report_format format;
+} format_names[] = {
+        { "text", MCT_REPORT_FORMAT_TEXT },
+        { "csv", MCT_REPORT_FORMAT_CSV },
+        { "json", MCT_REPORT_FORMAT_JSON },
+};
+
+bool
+mct_report_format_from_string(const char *name,
+                              enum mct_report_format *format)
+{
+        int i;
+
+        for (i = 0; i < sizeof format_names / sizeof format_names[0]; i++) {
+                if (!strcmp(format_names[i].name, name)) {
+                        *format = format_names[i].format;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+struct mct_report *
+mct_report_new(enum mct_report_format format,
+               FILE *out)
+{
+        struct mct_report *report = malloc(sizeof *report);
+
+        report->format = format;
+        report->out = out;
+        report->record = NULL;
+        report->n_fields = 0;
+        report->fields_size = INITIAL_FIELDS;
+        report->fields = malloc(sizeof *report->fields *
+                                report->fields_size);
+        report->header_record = NULL;
+        report->n_header_keys = 0;
+        report->header_keys_size = INITIAL_FIELDS;
+        report->header_keys = malloc(sizeof *report->header_keys *
+                                     report->header_keys_size);
+
+        return report;
+}
+
+enum mct_report_format
+mct_report_get_format(struct mct_report *report)
+{
+        return report->format;
+}
+
+void
+mct_report_begin_record(struct mct_report *report,
+                        const char *record)
+{
+        report->record = record;
+        report->n_fields = 0;
+}
+
+static void
+add_field(struct mct_report *report,
+          const char *key,
+          bool is_string,
+          const char *format,
+          ...)
+{
+        struct mct_report_field *field;
+        va_list ap;
+
+        if (report->n_fields >= report->fields_size) {
+                report->fields_size *= 2;
+                report->fields = realloc(report->fields,
+                                         sizeof *report->fields *
+                                         report->fields_size);
+        }
+
+        field = report->fields + report->n_fields++;
+        snprintf(field->key, sizeof field->key, "%s", key);
+        field->is_string = is_string;
+
+        va_start(ap, format);
+        vsnprintf(field->value, sizeof field->value, format, ap);
+        va_end(ap);
+}
+
+void
+mct_report_add_int(struct mct_report *report,
+                   const char *key,
+                   long long value)
+{
+        add_field(report, key, false, "%lli", value);
+}
+
+void
+mct_report_add_double(struct mct_report *report,
+                      const char *key,
+                      double value)
+{
+        add_field(report, key, false, "%.6g", value);
+}
+
+void
+mct_report_add_string(struct mct_report *report,
+                      const char *key,
+                      const char *value)
+{
+        add_field(report, key, true, "%s", value);
+}
+
+static bool
+header_matches(struct mct_report *report)
+{
+        int i;
+
+        if (report->header_record == NULL ||
+            strcmp(report->header_record, report->record) ||
+            report->n_header_keys != report->n_fields)
+                return false;
+
+        for (i = 0; i < report->n_fields; i++) {
+                if (strcmp(report->header_keys[i], report->fields[i].key))
+                        return false;
+        }
+
+        return true;
+}
+
+static void
+write_csv_string(FILE *out, const char *value)
+{
+        if (strpbrk(value, ",\"\n") == NULL) {
+                fputs(value, out);
+                return;
+        }
+
+        fputc('"', out);
+        for (; *value; value++) {
+                if (*value == '"')
+                        fputc('"', out);
+                fputc(*value, out);
+        }
+        fputc('"', out);
+}
+
+static void
+write_csv(struct mct_report *report)
+{
+        int i;
+
+        if (!header_matches(report)) {
+                if (report->n_fields > report->header_keys_size) {
+                        report->header_keys_size = report->fields_size;
+                        report->header_keys =
+                                realloc(report->header_keys,
+                                        sizeof *report->header_keys *
+                                        report->header_keys_size);
+                }
+
+                fputs("record", report->out);
+                for (i = 0; i < report->n_fields; i++) {
+                        fputc(',', report->out);
+                        fputs(report->fields[i].key, report->out);
+                        strcpy(report->header_keys[i],
+                               report->fields[i].key);
+                }
+                fputc('\n', report->out);
+
+                report->header_record = report->record;
+                report->n_header_keys = report->n_fields;
+        }
+
+        fputs(report->record, report->out);
+        for (i = 0; i < report->n_fields; i++) {
+                fputc(',', report->out);
+                write_csv_string(report->out, report->fields[i].value);
+        }
+        fputc('\n', report->out);
+}
+
+static void
+write_json_string(FILE *out, const char *value)
+{
+        fputc('"', out);
+        for (; *value; value++) {
+                if (*value == '"' || *value == '\\')
+                        fprintf(out, "\\%c", *value);
+                else if ((unsigned char) *value < ' ')
+                        fprintf(out, "\\u%04x", *value);
+                else
+                        fputc(*value, out);
+        }
+        fputc('"', out);
+}
+
+static void
+write_json(struct mct_report *report)
+{
+        const struct mct_report_field *field;
+        int i;
+
+        fputs("{\"record\":", report->out);
+        write_json_string(report->out, report->record);
+
+        for (i = 0; i < report->n_fields; i++) {
+                field = report->fields + i;
+                fputc(',', report->out);
+                write_json_string(report->out, field->key);
+                fputc(':', report->out);
+                /* JSON has no representation for infinity or NaN */
+                if (field->is_string)
+                        write_json_string(report->out, field->value);
+                else if (strpbrk(field->value, "ni"))
+                        fputs("null", report->out);
+                else
+                        fputs(field->value, report->out);
+        }
+
+        fputs("}\n", report->out);
+}
+
+static void
+write_text(struct mct_report *report)
+{
+        int i;
+
+        fprintf(report->out, "%s:", report->record);
+
+        for (i = 0; i < report->n_fields; i++) {
+                fprintf(report->out,
+                        " %s=%s",
+                        report->fields[i].key,
+                        report->fields[i].value);
+        }
+
+        fputc('\n', report->out);
+}
+
+void
+mct_report_end_record(struct mct_report *report)
+{
+        switch (report->format) {
+        case MCT_REPORT_FORMAT_TEXT:
+                write_text(report);
+                break;
+        case MCT_REPORT_FORMAT_CSV:
+                write_csv(report);
+                break;
+        case MCT_REPORT_FORMAT_JSON:
+                write_json(report);
+                break;
+        }
+
+        fflush(report->out);
+
+        report->record = NULL;
+        report->n_fields = 0;
+}
+
+void
+mct_report_free(struct mct_report *report)
+{
+        free(report->header_keys);
+        free(report->fields);
+        free(report);
+}
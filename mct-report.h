@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_REPORT_H
+#define MCT_REPORT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/* A report is a series of records, each of which is a flat list of
+ * key/value pairs. Every record has a type name so that consumers of
+ * the CSV and JSON output can tell the different kinds of rows apart.
+ * In CSV mode a new header line is emitted whenever the set of columns
+ * changes. */
+
+enum mct_report_format {
+        MCT_REPORT_FORMAT_TEXT,
+        MCT_REPORT_FORMAT_CSV,
+        MCT_REPORT_FORMAT_JSON
+};
+
+struct mct_report;
+
+bool
+mct_report_format_from_string(const char *name,
+                              enum mct_report_format *format);
+
+struct mct_report *
+mct_report_new(enum mct_report_format format,
+               FILE *out);
+
+enum mct_report_format
+mct_report_get_format(struct mct_report *report);
+
+void
+mct_report_begin_record(struct mct_report *report,
+                        const char *record);
+
+void
+mct_report_add_int(struct mct_report *report,
+                   const char *key,
+                   long long value);
+
+void
+mct_report_add_double(struct mct_report *report,
+                      const char *key,
+                      double value);
+
+void
+mct_report_add_string(struct mct_report *report,
+                      const char *key,
+                      const char *value);
+
+void
+mct_report_end_record(struct mct_report *report);
+
+void
+mct_report_free(struct mct_report *report);
+
+#endif /* MCT_REPORT_H */
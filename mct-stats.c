@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <math.h>
+#include <float.h>
+
+#include "mct-stats.h"
+
+void
+mct_stats_describe(const double *samples,
+                   int count,
+                   struct mct_sample_stats *stats)
+{
+        double sum = 0.0, sum_squares = 0.0, d;
+        int i;
+
+        for (i = 0; i < count; i++)
+                sum += samples[i];
+
+        stats->count = count;
+        stats->mean = count > 0 ? sum / count : 0.0;
+
+        /* Two passes to avoid cancellation */
+        for (i = 0; i < count; i++) {
+                d = samples[i] - stats->mean;
+                sum_squares += d * d;
+        }
+
+        stats->variance = count > 1 ? sum_squares / (count - 1) : 0.0;
+}
+
+/* Continued fraction for the incomplete beta function, evaluated with
+ * the modified Lentz method */
+static double
+beta_continued_fraction(double a,
+                        double b,
+                        double x)
+{
+        const double tiny = 1e-300;
+        double c = 1.0, d, h, aa, del;
+        int m, m2;
+
+        d = 1.0 - (a + b) * x / (a + 1.0);
+        if (fabs(d) < tiny)
+                d = tiny;
+        d = 1.0 / d;
+        h = d;
+
+        for (m = 1; m <= 300; m++) {
+                m2 = 2 * m;
+
+                aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+                d = 1.0 + aa * d;
+                if (fabs(d) < tiny)
+                        d = tiny;
+                c = 1.0 + aa / c;
+                if (fabs(c) < tiny)
+                        c = tiny;
+                d = 1.0 / d;
+                h *= d * c;
+
+                aa = -(a + m) * (a + b + m) * x /
+                        ((a + m2) * (a + m2 + 1.0));
+                d = 1.0 + aa * d;
+                if (fabs(d) < tiny)
+                        d = tiny;
+                c = 1.0 + aa / c;
+                if (fabs(c) < tiny)
+                        c = tiny;
+                d = 1.0 / d;
+                del = d * c;
+                h *= del;
+
+                if (fabs(del - 1.0) < DBL_EPSILON)
+                        break;
+        }
+
+        return h;
+}
+
+/* Regularized incomplete beta function I_x(a, b) */
+static double
+incomplete_beta(double a,
+                double b,
+                double x)
+{
+        double front;
+
+        if (x <= 0.0)
+                return 0.0;
+        if (x >= 1.0)
+                return 1.0;
+
+        front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) +
+                    a * log(x) + b * log(1.0 - x));
+
+        if (x < (a + 1.0) / (a + b + 2.0))
+                return front * beta_continued_fraction(a, b, x) / a;
+        else
+                return 1.0 - front * beta_continued_fraction(b, a, 1.0 - x) / b;
+}
+
+/* Probability that |T| >= t for Student's t distribution */
+static double
+t_two_sided_p(double t,
+              double df)
+{
+        return incomplete_beta(df / 2.0, 0.5, df / (df + t * t));
+}
+
+static double
+t_critical_value(double confidence,
+                 double df)
+{
+        double low = 0.0, high = 1e3, mid;
+        int i;
+
+        /* The p-value decreases monotonically with t so bisect */
+        for (i = 0; i < 100; i++) {
+                mid = (low + high) / 2.0;
+                if (t_two_sided_p(mid, df) > 1.0 - confidence)
+                        low = mid;
+                else
+                        high = mid;
+        }
+
+        return (low + high) / 2.0;
+}
+
+void
+mct_stats_compare(const struct mct_sample_stats *a,
+                  const struct mct_sample_stats *b,
+                  double confidence,
+                  struct mct_comparison *comparison)
+{
+        double va = a->variance / a->count;
+        double vb = b->variance / b->count;
+        double se = sqrt(va + vb);
+        double margin;
+
+        comparison->difference = b->mean - a->mean;
+
+        if (se <= 0.0) {
+                /* Both sets are constant so there is no doubt */
+                comparison->t = (comparison->difference == 0.0 ?
+                                 0.0 :
+                                 copysign(INFINITY, comparison->difference));
+                comparison->df = a->count + b->count - 2;
+                comparison->p_value = comparison->difference == 0.0 ? 1.0 : 0.0;
+                comparison->ci_low = comparison->difference;
+                comparison->ci_high = comparison->difference;
+                return;
+        }
+
+        comparison->t = comparison->difference / se;
+        comparison->df = ((va + vb) * (va + vb) /
+                          (va * va / (a->count - 1) +
+                           vb * vb / (b->count - 1)));
+        comparison->p_value = t_two_sided_p(comparison->t, comparison->df);
+
+        margin = t_critical_value(confidence, comparison->df) * se;
+        comparison->ci_low = comparison->difference - margin;
+        comparison->ci_high = comparison->difference + margin;
+}
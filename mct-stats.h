@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_STATS_H
+#define MCT_STATS_H
+
+/* Summary of a set of independent samples */
+struct mct_sample_stats {
+        int count;
+        double mean;
+        /* Unbiased sample variance */
+        double variance;
+};
+
+/* Result of comparing the means of two sets of samples with Welch's
+ * t-test, which doesn't assume that the variances are equal */
+struct mct_comparison {
+        /* Mean of b minus mean of a */
+        double difference;
+        /* Confidence interval of the difference */
+        double ci_low, ci_high;
+        double t;
+        /* Welch–Satterthwaite degrees of freedom */
+        double df;
+        /* Two-sided p-value for the null hypothesis that the means
+         * are equal */
+        double p_value;
+};
+
+void
+mct_stats_describe(const double *samples,
+                   int count,
+                   struct mct_sample_stats *stats);
+
+/* Both sets need at least two samples. confidence is the level of the
+ * interval, for example 0.95. */
+void
+mct_stats_compare(const struct mct_sample_stats *a,
+                  const struct mct_sample_stats *b,
+                  double confidence,
+                  struct mct_comparison *comparison);
+
+#endif /* MCT_STATS_H */
@@ -0,0 +1,178 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mct-stream.h"
+#include "mct-timing.h"
+
+#define N_SEGMENTS 3
+
+struct mct_stream {
+        GLuint buffer;
+        uint8_t *map;
+        size_t segment_size;
+
+        int segment;
+        /* Fence after the last frame that used each segment */
+        GLsync fences[N_SEGMENTS];
+
+        struct mct_stream_stats stats;
+};
+
+struct mct_stream *
+mct_stream_new(size_t segment_size)
+{
+        const GLbitfield flags = (GL_MAP_WRITE_BIT |
+                                  GL_MAP_PERSISTENT_BIT |
+                                  GL_MAP_COHERENT_BIT);
+        struct mct_stream *stream;
+        int i;
+
+        if (epoxy_gl_version() < 44 &&
+            !epoxy_has_gl_extension("GL_ARB_buffer_storage")) {
+                fprintf(stderr,
+                        "Streaming requires GL_ARB_buffer_storage\n");
+                return NULL;
+        }
+
+        stream = malloc(sizeof *stream);
+
+        stream->segment_size = segment_size;
+        stream->segment = 0;
+        for (i = 0; i < N_SEGMENTS; i++)
+                stream->fences[i] = NULL;
+
+        glGenBuffers(1, &stream->buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+        glBufferStorage(GL_ARRAY_BUFFER,
+                        segment_size * N_SEGMENTS,
+                        NULL,
+                        flags);
+        stream->map = glMapBufferRange(GL_ARRAY_BUFFER,
+                                       0, /* offset */
+                                       segment_size * N_SEGMENTS,
+                                       flags);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        if (stream->map == NULL) {
+                fprintf(stderr, "Failed to map the stream buffer\n");
+                glDeleteBuffers(1, &stream->buffer);
+                free(stream);
+                return NULL;
+        }
+
+        stream->stats.bytes = 0;
+        stream->stats.write_time = 0;
+        stream->stats.wait_time = 0;
+        stream->stats.n_stalls = 0;
+
+        return stream;
+}
+
+GLuint
+mct_stream_get_buffer(struct mct_stream *stream)
+{
+        return stream->buffer;
+}
+
+size_t
+mct_stream_get_size(struct mct_stream *stream)
+{
+        return stream->segment_size * N_SEGMENTS;
+}
+
+void *
+mct_stream_begin(struct mct_stream *stream,
+                 size_t *offset)
+{
+        GLsync fence = stream->fences[stream->segment];
+        uint64_t start_time;
+        GLenum result;
+
+        if (fence) {
+                result = glClientWaitSync(fence, 0, 0);
+
+                if (result == GL_TIMEOUT_EXPIRED) {
+                        /* The fence might not have been flushed yet
+                         * if the release behavior is none */
+                        start_time = mct_get_time_ns();
+                        glClientWaitSync(fence,
+                                         GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         UINT64_MAX);
+                        stream->stats.wait_time +=
+                                mct_get_time_ns() - start_time;
+                        stream->stats.n_stalls++;
+                }
+
+                glDeleteSync(fence);
+                stream->fences[stream->segment] = NULL;
+        }
+
+        *offset = stream->segment * stream->segment_size;
+
+        return stream->map + *offset;
+}
+
+void
+mct_stream_end(struct mct_stream *stream,
+               uint64_t write_time)
+{
+        stream->fences[stream->segment] =
+                glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        stream->stats.bytes += stream->segment_size;
+        stream->stats.write_time += write_time;
+
+        stream->segment = (stream->segment + 1) % N_SEGMENTS;
+}
+
+const struct mct_stream_stats *
+mct_stream_get_stats(struct mct_stream *stream)
+{
+        return &stream->stats;
+}
+
+void
+mct_stream_free(struct mct_stream *stream)
+{
+        int i;
+
+        for (i = 0; i < N_SEGMENTS; i++) {
+                if (stream->fences[i])
+                        glDeleteSync(stream->fences[i]);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, stream->buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glDeleteBuffers(1, &stream->buffer);
+
+        free(stream);
+}
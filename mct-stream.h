@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_STREAM_H
+#define MCT_STREAM_H
+
+#include <epoxy/gl.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* A buffer that is rewritten every frame. The buffer is created with
+ * ARB_buffer_storage and kept persistently and coherently mapped. It
+ * is split into a ring of segments so that the CPU can write the
+ * next frame while the GPU is still reading the previous ones. A
+ * fence at the end of each frame guards the segment's reuse. */
+
+struct mct_stream;
+
+struct mct_stream_stats {
+        /* Bytes written into the mapped buffer */
+        uint64_t bytes;
+        /* CPU time spent writing them in nanoseconds */
+        uint64_t write_time;
+        /* Time spent waiting for a segment to become free */
+        uint64_t wait_time;
+        /* Number of frames that had to wait at all */
+        uint64_t n_stalls;
+};
+
+/* These must all be called with the context current */
+
+/* Returns NULL if persistent mapping isn't supported */
+struct mct_stream *
+mct_stream_new(size_t segment_size);
+
+GLuint
+mct_stream_get_buffer(struct mct_stream *stream);
+
+/* Total size of the buffer including all of the segments */
+size_t
+mct_stream_get_size(struct mct_stream *stream);
+
+/* Waits for the next segment to be free and returns a pointer to
+ * write it directly. The offset of the segment within the buffer is
+ * returned in offset. */
+void *
+mct_stream_begin(struct mct_stream *stream,
+                 size_t *offset);
+
+/* Must be called after the draw calls that read the segment.
+ * write_time is the CPU time the caller spent filling it. */
+void
+mct_stream_end(struct mct_stream *stream,
+               uint64_t write_time);
+
+const struct mct_stream_stats *
+mct_stream_get_stats(struct mct_stream *stream);
+
+void
+mct_stream_free(struct mct_stream *stream);
+
+#endif /* MCT_STREAM_H */
@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "mct-timing.h"
+
+uint64_t
+mct_get_time_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+void
+mct_histogram_init(struct mct_histogram *histogram)
+{
+        memset(histogram, 0, sizeof *histogram);
+        histogram->min = UINT64_MAX;
+}
+
+static int
+get_bucket(uint64_t value)
+{
+        int exponent;
+
+        if (value < (1 << MCT_HISTOGRAM_SUB_BITS))
+                return value;
+
+        exponent = 63 - __builtin_clzll(value);
+
+        return (((exponent - MCT_HISTOGRAM_SUB_BITS + 1) <<
+                 MCT_HISTOGRAM_SUB_BITS) |
+                ((value >> (exponent - MCT_HISTOGRAM_SUB_BITS)) &
+                 ((1 << MCT_HISTOGRAM_SUB_BITS) - 1)));
+}
+
+static uint64_t
+get_bucket_middle(int bucket)
+{
+        int exponent, sub;
+        uint64_t start;
+
+        if (bucket < (1 << MCT_HISTOGRAM_SUB_BITS))
+                return bucket;
+
+        exponent = (bucket >> MCT_HISTOGRAM_SUB_BITS) +
+                MCT_HISTOGRAM_SUB_BITS - 1;
+        sub = bucket & ((1 << MCT_HISTOGRAM_SUB_BITS) - 1);
+        start = (UINT64_C(1) << exponent) +
+                ((uint64_t) sub << (exponent - MCT_HISTOGRAM_SUB_BITS));
+
+        return start + (UINT64_C(1) << (exponent - MCT_HISTOGRAM_SUB_BITS)) / 2;
+}
+
+void
+mct_histogram_add(struct mct_histogram *histogram,
+                  uint64_t value)
+{
+        histogram->buckets[get_bucket(value)]++;
+        histogram->count++;
+        histogram->sum += value;
+
+        if (value < histogram->min)
+                histogram->min = value;
+        if (value > histogram->max)
+                histogram->max = value;
+}
+
+void
+mct_histogram_merge(struct mct_histogram *histogram,
+                    const struct mct_histogram *other)
+{
+        int i;
+
+        for (i = 0; i < MCT_HISTOGRAM_N_BUCKETS; i++)
+                histogram->buckets[i] += other->buckets[i];
+
+        histogram->count += other->count;
+        histogram->sum += other->sum;
+
+        if (other->min < histogram->min)
+                histogram->min = other->min;
+        if (other->max > histogram->max)
+                histogram->max = other->max;
+}
+
+uint64_t
+mct_histogram_percentile(const struct mct_histogram *histogram,
+                         double percentile)
+{
+        uint64_t target, total = 0, value;
+        int i;
+
+        if (histogram->count == 0)
+                return 0;
+
+        target = histogram->count * percentile / 100.0;
+        if (target < 1)
+                target = 1;
+
+        for (i = 0; i < MCT_HISTOGRAM_N_BUCKETS; i++) {
+                total += histogram->buckets[i];
+                if (total >= target)
+                        break;
+        }
+
+        value = get_bucket_middle(i);
+
+        /* The exact extremes are known so don't report a bucket
+         * estimate outside of them */
+        if (value < histogram->min)
+                value = histogram->min;
+        if (value > histogram->max)
+                value = histogram->max;
+
+        return value;
+}
+
+void
+mct_histogram_add_to_report(const struct mct_histogram *histogram,
+                            struct mct_report *report,
+                            const char *prefix,
+                            const char *unit,
+                            double unit_ns)
+{
+        static const struct {
+                const char *name;
+                double percentile;
+        } stats[] = {
+                { "p50", 50.0 },
+                { "p90", 90.0 },
+                { "p99", 99.0 },
+        };
+        char key[64];
+        int i;
+
+        snprintf(key, sizeof key, "%s_min_%s", prefix, unit);
+        mct_report_add_double(report,
+                              key,
+                              histogram->count ?
+                              histogram->min / unit_ns :
+                              0.0);
+
+        for (i = 0; i < sizeof stats / sizeof stats[0]; i++) {
+                snprintf(key, sizeof key,
+                         "%s_%s_%s",
+                         prefix, stats[i].name, unit);
+                mct_report_add_double(report,
+                                      key,
+                                      mct_histogram_percentile(histogram,
+                                                               stats[i].
+                                                               percentile) /
+                                      unit_ns);
+        }
+
+        snprintf(key, sizeof key, "%s_max_%s", prefix, unit);
+        mct_report_add_double(report, key, histogram->max / unit_ns);
+}
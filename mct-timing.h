@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_TIMING_H
+#define MCT_TIMING_H
+
+#include <stdint.h>
+
+#include "mct-report.h"
+
+/* The histogram buckets are log-linear. Values below 16 each get
+ * their own bucket and above that each power of two is split into 16
+ * sub-buckets so the relative error is at most about 6%. Everything
+ * is preallocated so adding a value never touches the heap. */
+
+#define MCT_HISTOGRAM_SUB_BITS 4
+#define MCT_HISTOGRAM_N_BUCKETS \
+        ((64 - MCT_HISTOGRAM_SUB_BITS + 1) << MCT_HISTOGRAM_SUB_BITS)
+
+struct mct_histogram {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t min;
+        uint64_t max;
+        uint32_t buckets[MCT_HISTOGRAM_N_BUCKETS];
+};
+
+uint64_t
+mct_get_time_ns(void);
+
+void
+mct_histogram_init(struct mct_histogram *histogram);
+
+void
+mct_histogram_add(struct mct_histogram *histogram,
+                  uint64_t value);
+
+void
+mct_histogram_merge(struct mct_histogram *histogram,
+                    const struct mct_histogram *other);
+
+uint64_t
+mct_histogram_percentile(const struct mct_histogram *histogram,
+                         double percentile);
+
+/* Adds the min, p50, p90, p99 and max of the histogram to the current
+ * record as <prefix>_<stat>_<unit>. The values are divided by
+ * unit_ns. */
+void
+mct_histogram_add_to_report(const struct mct_histogram *histogram,
+                            struct mct_report *report,
+                            const char *prefix,
+                            const char *unit,
+                            double unit_ns);
+
+#endif /* MCT_TIMING_H */
@@ -0,0 +1,280 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mct-trace.h"
+#include "mct-timing.h"
+
+struct mct_trace_record {
+        uint64_t start_time;
+        uint32_t duration;
+        uint16_t event;
+        int16_t context;
+        int32_t arg;
+};
+
+struct mct_trace_ring {
+        char *name;
+        int tid;
+        /* Total number of events recorded. The next one goes at
+         * n_events & mask. */
+        uint64_t n_events;
+        uint64_t mask;
+        struct mct_trace_record *records;
+        struct mct_trace_ring *next;
+};
+
+static const char *const
+event_names[MCT_TRACE_N_EVENTS] = {
+        [MCT_TRACE_FRAME] = "frame",
+        [MCT_TRACE_MAKE_CURRENT] = "make_current",
+        [MCT_TRACE_START] = "start",
+        [MCT_TRACE_DRAW_ROWS] = "draw_rows",
+        [MCT_TRACE_END] = "end",
+        [MCT_TRACE_SWAP] = "swap",
+};
+
+/* The list of rings is only modified when a thread picks its ring so
+ * the lock is never taken while recording */
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct mct_trace_ring *rings;
+static int n_rings;
+static uint64_t ring_size;
+static uint64_t trace_start_time;
+
+static __thread struct mct_trace_ring *current_ring;
+
+void
+mct_trace_init(int events_per_thread)
+{
+        /* Round up to a power of two so that wrapping is a mask */
+        ring_size = 1;
+        while (ring_size < (uint64_t) events_per_thread)
+                ring_size <<= 1;
+
+        trace_start_time = mct_get_time_ns();
+}
+
+bool
+mct_trace_is_enabled(void)
+{
+        return ring_size > 0;
+}
+
+static struct mct_trace_ring *
+get_ring(const char *name)
+{
+        struct mct_trace_ring *ring;
+
+        for (ring = rings; ring; ring = ring->next) {
+                if (!strcmp(ring->name, name))
+                        return ring;
+        }
+
+        ring = malloc(sizeof *ring);
+        ring->name = strdup(name);
+        ring->tid = n_rings++;
+        ring->n_events = 0;
+        ring->mask = ring_size - 1;
+        ring->records = malloc(sizeof *ring->records * ring_size);
+        /* Touch all of the pages now so that recording doesn't take
+         * page faults */
+        memset(ring->records, 0, sizeof *ring->records * ring_size);
+        ring->next = rings;
+        rings = ring;
+
+        return ring;
+}
+
+void
+mct_trace_set_thread(const char *name)
+{
+        if (ring_size == 0)
+                return;
+
+        pthread_mutex_lock(&rings_mutex);
+        current_ring = get_ring(name);
+        pthread_mutex_unlock(&rings_mutex);
+}
+
+uint64_t
+mct_trace_begin(void)
+{
+        if (current_ring == NULL)
+                return 0;
+
+        return mct_get_time_ns();
+}
+
+void
+mct_trace_add(enum mct_trace_event event,
+              uint64_t start_time,
+              uint64_t end_time,
+              int context,
+              int arg)
+{
+        struct mct_trace_ring *ring = current_ring;
+        struct mct_trace_record *record;
+        uint64_t duration;
+
+        if (ring == NULL)
+                return;
+
+        record = ring->records + (ring->n_events++ & ring->mask);
+
+        duration = end_time - start_time;
+        if (duration > UINT32_MAX)
+                duration = UINT32_MAX;
+
+        record->start_time = start_time;
+        record->duration = duration;
+        record->event = event;
+        record->context = context;
+        record->arg = arg;
+}
+
+uint64_t
+mct_trace_end(enum mct_trace_event event,
+              uint64_t start_time,
+              int context,
+              int arg)
+{
+        uint64_t end_time;
+
+        if (current_ring == NULL)
+                return 0;
+
+        end_time = mct_get_time_ns();
+
+        mct_trace_add(event, start_time, end_time, context, arg);
+
+        return end_time;
+}
+
+static void
+write_record(FILE *out,
+             int pid,
+             const struct mct_trace_ring *ring,
+             const struct mct_trace_record *record)
+{
+        fprintf(out,
+                ",\n{\"name\":\"%s\",\"cat\":\"mct\",\"ph\":\"X\","
+                "\"pid\":%i,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{",
+                event_names[record->event],
+                pid,
+                ring->tid,
+                (int64_t) (record->start_time - trace_start_time) / 1e3,
+                record->duration / 1e3);
+
+        if (record->context >= 0) {
+                fprintf(out, "\"context\":%i", record->context);
+                if (record->event == MCT_TRACE_DRAW_ROWS)
+                        fprintf(out, ",\"row\":%i", record->arg);
+        }
+
+        fputs("}}", out);
+}
+
+static void
+write_ring(FILE *out,
+           int pid,
+           const struct mct_trace_ring *ring)
+{
+        uint64_t first = 0, i;
+
+        fprintf(out,
+                ",\n{\"name\":\"thread_name\",\"ph\":\"M\","
+                "\"pid\":%i,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+                pid,
+                ring->tid,
+                ring->name);
+
+        if (ring->n_events > ring_size) {
+                first = ring->n_events - ring_size;
+                fprintf(stderr,
+                        "note: the trace for %s dropped its oldest "
+                        "%llu events\n",
+                        ring->name,
+                        (unsigned long long) first);
+        }
+
+        for (i = first; i < ring->n_events; i++)
+                write_record(out, pid, ring, ring->records + (i & ring->mask));
+}
+
+bool
+mct_trace_write(const char *filename)
+{
+        const struct mct_trace_ring *ring;
+        int pid = getpid();
+        FILE *out;
+
+        out = fopen(filename, "w");
+        if (out == NULL) {
+                fprintf(stderr, "%s: %m\n", filename);
+                return false;
+        }
+
+        fprintf(out,
+                "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,"
+                "\"args\":{\"name\":\"multi-context-test\"}}",
+                pid);
+
+        for (ring = rings; ring; ring = ring->next)
+                write_ring(out, pid, ring);
+
+        fputs("\n]}\n", out);
+
+        if (fclose(out) == EOF) {
+                fprintf(stderr, "%s: %m\n", filename);
+                return false;
+        }
+
+        return true;
+}
+
+void
+mct_trace_fini(void)
+{
+        struct mct_trace_ring *ring, *next;
+
+        for (ring = rings; ring; ring = next) {
+                next = ring->next;
+                free(ring->records);
+                free(ring->name);
+                free(ring);
+        }
+
+        rings = NULL;
+        n_rings = 0;
+        ring_size = 0;
+        current_ring = NULL;
+}
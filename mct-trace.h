@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef MCT_TRACE_H
+#define MCT_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Records timestamped events into a preallocated ring buffer for each
+ * thread and writes them out in the Chrome trace event format so that
+ * individual frames can be inspected in chrome://tracing or Perfetto.
+ * Each ring only has one writer so recording an event takes no locks
+ * and never allocates. When a ring is full the oldest events are
+ * overwritten. */
+
+enum mct_trace_event {
+        MCT_TRACE_FRAME,
+        MCT_TRACE_MAKE_CURRENT,
+        MCT_TRACE_START,
+        MCT_TRACE_DRAW_ROWS,
+        MCT_TRACE_END,
+        MCT_TRACE_SWAP,
+};
+
+#define MCT_TRACE_N_EVENTS (MCT_TRACE_SWAP + 1)
+
+/* Enables tracing with room for the given number of events in each
+ * thread's ring. Until this is called all of the other functions do
+ * nothing. */
+void
+mct_trace_init(int events_per_thread);
+
+bool
+mct_trace_is_enabled(void);
+
+/* Selects the ring that events from the calling thread are recorded
+ * into. Threads with the same name share a track in the trace so only
+ * one of them may be running at a time. */
+void
+mct_trace_set_thread(const char *name);
+
+/* Returns the start time to pass to mct_trace_end or 0 if the calling
+ * thread isn't tracing */
+uint64_t
+mct_trace_begin(void);
+
+/* The context is added to the event's arguments unless it is
+ * negative. For MCT_TRACE_DRAW_ROWS arg is the first row. Returns
+ * the end time so that it can also be the start of the next event
+ * without reading the clock again. */
+uint64_t
+mct_trace_end(enum mct_trace_event event,
+              uint64_t start_time,
+              int context,
+              int arg);
+
+/* Records an event whose times were already measured */
+void
+mct_trace_add(enum mct_trace_event event,
+              uint64_t start_time,
+              uint64_t end_time,
+              int context,
+              int arg);
+
+/* Writes all of the recorded events. None of the traced threads may
+ * be running. */
+bool
+mct_trace_write(const char *filename);
+
+void
+mct_trace_fini(void);
+
+#endif /* MCT_TRACE_H */
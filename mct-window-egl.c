@@ -0,0 +1,408 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <epoxy/egl.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mct-window-private.h"
+
+#ifndef EGL_CONTEXT_RELEASE_BEHAVIOR_KHR
+#define EGL_CONTEXT_RELEASE_BEHAVIOR_KHR 0x2097
+#endif
+#ifndef EGL_CONTEXT_RELEASE_BEHAVIOR_NONE_KHR
+#define EGL_CONTEXT_RELEASE_BEHAVIOR_NONE_KHR 0
+#endif
+#ifndef EGL_CONTEXT_RELEASE_BEHAVIOR_FLUSH_KHR
+#define EGL_CONTEXT_RELEASE_BEHAVIOR_FLUSH_KHR 0x2098
+#endif
+
+#ifndef EGL_PLATFORM_DEVICE_EXT
+#define EGL_PLATFORM_DEVICE_EXT 0x313F
+#endif
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+/* The EGL backend doesn't need a window system at all. Each “window”
+ * is a pbuffer surface on a surfaceless or device display so that
+ * the benchmark can run on a headless render node or on llvmpipe in
+ * a container. */
+
+struct mct_display_egl {
+        struct mct_display base;
+        EGLDisplay egl_display;
+        EGLConfig config;
+        bool has_flush_ext;
+        bool has_surfaceless_ext;
+};
+
+struct mct_window_egl {
+        struct mct_window base;
+        EGLDisplay egl_display;
+        /* EGL_NO_SURFACE if the window is surfaceless */
+        EGLSurface surface;
+        EGLContext context;
+};
+
+static bool
+check_egl_extension(EGLDisplay egl_display, const char *ext_name)
+{
+        int ext_len = strlen(ext_name);
+        const char *extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+        const char *extensions_end;
+
+        if (extensions == NULL)
+                return false;
+
+        extensions_end = extensions + strlen(extensions);
+
+        while (extensions < extensions_end) {
+                const char *end = strchr(extensions, ' ');
+
+                if (end == NULL)
+                        end = extensions_end;
+
+                if (end - extensions == ext_len &&
+                    !memcmp(extensions, ext_name, ext_len))
+                        return true;
+
+                extensions = end + 1;
+        }
+
+        return false;
+}
+
+static EGLDisplay
+get_device_display(PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display)
+{
+        PFNEGLQUERYDEVICESEXTPROC query_devices;
+        EGLDeviceEXT device;
+        EGLint n_devices;
+
+        if (!check_egl_extension(EGL_NO_DISPLAY, "EGL_EXT_platform_device"))
+                return EGL_NO_DISPLAY;
+
+        query_devices =
+                (void *) eglGetProcAddress("eglQueryDevicesEXT");
+
+        if (query_devices == NULL ||
+            !query_devices(1, &device, &n_devices) ||
+            n_devices < 1)
+                return EGL_NO_DISPLAY;
+
+        return get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, NULL);
+}
+
+static EGLDisplay
+get_headless_display(void)
+{
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+        EGLDisplay egl_display;
+
+        if (!check_egl_extension(EGL_NO_DISPLAY, "EGL_EXT_platform_base"))
+                return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        get_platform_display =
+                (void *) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        /* Prefer the Mesa surfaceless platform because it doesn't
+         * need any device nodes. Otherwise fall back to the first
+         * device that EGL can enumerate, which will typically be a
+         * render node. */
+        if (check_egl_extension(EGL_NO_DISPLAY,
+                                "EGL_MESA_platform_surfaceless")) {
+                egl_display =
+                        get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                             EGL_DEFAULT_DISPLAY,
+                                             NULL);
+                if (egl_display != EGL_NO_DISPLAY)
+                        return egl_display;
+        }
+
+        egl_display = get_device_display(get_platform_display);
+        if (egl_display != EGL_NO_DISPLAY)
+                return egl_display;
+
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool
+choose_config(EGLDisplay egl_display, EGLConfig *config)
+{
+        static const EGLint attrib_list[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_NONE
+        };
+        EGLint n_configs;
+
+        return (eglChooseConfig(egl_display,
+                                attrib_list,
+                                config, 1,
+                                &n_configs) &&
+                n_configs >= 1);
+}
+
+static struct mct_display *
+open_display(void)
+{
+        struct mct_display_egl *display;
+        EGLDisplay egl_display;
+        EGLConfig config;
+        EGLint major, minor;
+
+        egl_display = get_headless_display();
+
+        if (egl_display == EGL_NO_DISPLAY) {
+                fprintf(stderr, "Failed to get an EGL display\n");
+                return NULL;
+        }
+
+        if (!eglInitialize(egl_display, &major, &minor)) {
+                fprintf(stderr, "eglInitialize failed\n");
+                return NULL;
+        }
+
+        if (!check_egl_extension(egl_display, "EGL_KHR_create_context") &&
+            (major < 1 || (major == 1 && minor < 5))) {
+                fprintf(stderr,
+                        "EGL_KHR_create_context is not supported\n");
+                goto error;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+                fprintf(stderr, "EGL does not support desktop GL\n");
+                goto error;
+        }
+
+        if (!choose_config(egl_display, &config)) {
+                fprintf(stderr, "No suitable EGLConfig found\n");
+                goto error;
+        }
+
+        display = malloc(sizeof *display);
+        display->egl_display = egl_display;
+        display->config = config;
+        display->has_flush_ext =
+                check_egl_extension(egl_display,
+                                    "EGL_KHR_context_flush_control");
+        display->has_surfaceless_ext =
+                check_egl_extension(egl_display,
+                                    "EGL_KHR_surfaceless_context");
+
+        return &display->base;
+
+error:
+        eglTerminate(egl_display);
+        return NULL;
+}
+
+static void
+close_display(struct mct_display *base)
+{
+        struct mct_display_egl *display = (struct mct_display_egl *) base;
+
+        eglTerminate(display->egl_display);
+        free(display);
+}
+
+static void
+init_thread(struct mct_display *base)
+{
+        /* The bound API is per-thread state */
+        eglBindAPI(EGL_OPENGL_API);
+}
+
+static void
+release_current(struct mct_display *base)
+{
+        struct mct_display_egl *display = (struct mct_display_egl *) base;
+
+        eglMakeCurrent(display->egl_display,
+                       EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       EGL_NO_CONTEXT);
+}
+
+static void
+window_make_current(struct mct_window *base)
+{
+        struct mct_window_egl *window = (struct mct_window_egl *) base;
+
+        eglMakeCurrent(window->egl_display,
+                       window->surface,
+                       window->surface,
+                       window->context);
+}
+
+static void
+window_swap(struct mct_window *base)
+{
+        struct mct_window_egl *window = (struct mct_window_egl *) base;
+
+        if (window->surface != EGL_NO_SURFACE)
+                eglSwapBuffers(window->egl_display, window->surface);
+}
+
+static void
+window_show(struct mct_window *base)
+{
+        /* There's nothing to map for a pbuffer */
+}
+
+static struct mct_window *
+window_new(struct mct_display *base_display,
+           int width, int height,
+           bool flush_on_release,
+           bool surfaceless,
+           struct mct_window *share_window)
+{
+        struct mct_display_egl *display =
+                (struct mct_display_egl *) base_display;
+        EGLint context_attribs[] = {
+                EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+                EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
+                EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+                EGL_CONTEXT_FLAGS_KHR,
+                EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR,
+                EGL_CONTEXT_RELEASE_BEHAVIOR_KHR,
+                EGL_CONTEXT_RELEASE_BEHAVIOR_NONE_KHR,
+                EGL_NONE
+        };
+        EGLint surface_attribs[] = {
+                EGL_WIDTH, width,
+                EGL_HEIGHT, height,
+                EGL_NONE
+        };
+        struct mct_window_egl *window;
+        EGLContext ctx, share_context = EGL_NO_CONTEXT;
+        EGLSurface surface;
+
+        if (flush_on_release) {
+                if (display->has_flush_ext) {
+                        context_attribs[sizeof context_attribs /
+                                        sizeof context_attribs[0] - 2] =
+                                EGL_CONTEXT_RELEASE_BEHAVIOR_FLUSH_KHR;
+                } else {
+                        context_attribs[sizeof context_attribs /
+                                        sizeof context_attribs[0] - 3] =
+                                EGL_NONE;
+                }
+        } else if (!display->has_flush_ext) {
+                fprintf(stderr,
+                        "Requested disabling flush on release but "
+                        "EGL_KHR_context_flush_control is not "
+                        "available\n");
+                return NULL;
+        }
+
+        if (surfaceless && !display->has_surfaceless_ext) {
+                fprintf(stderr,
+                        "EGL_KHR_surfaceless_context is not available\n");
+                return NULL;
+        }
+
+        if (share_window) {
+                share_context =
+                        ((struct mct_window_egl *) share_window)->context;
+        }
+
+        ctx = eglCreateContext(display->egl_display,
+                               display->config,
+                               share_context,
+                               context_attribs);
+
+        if (ctx == EGL_NO_CONTEXT) {
+                fprintf(stderr,
+                        "Error: eglCreateContext failed\n");
+                return NULL;
+        }
+
+        if (surfaceless) {
+                surface = EGL_NO_SURFACE;
+        } else {
+                surface = eglCreatePbufferSurface(display->egl_display,
+                                                  display->config,
+                                                  surface_attribs);
+        }
+
+        if (surface == EGL_NO_SURFACE && !surfaceless) {
+                fprintf(stderr,
+                        "Error: eglCreatePbufferSurface failed\n");
+                eglDestroyContext(display->egl_display, ctx);
+                return NULL;
+        }
+
+        window = malloc(sizeof *window);
+
+        window->egl_display = display->egl_display;
+        window->surface = surface;
+        window->context = ctx;
+
+        return &window->base;
+}
+
+static void
+window_set_swap_interval(struct mct_window *base,
+                         int interval)
+{
+        /* Pbuffers are never presented so there is no swap interval
+         * to set */
+}
+
+static void
+window_free(struct mct_window *base)
+{
+        struct mct_window_egl *window = (struct mct_window_egl *) base;
+
+        eglMakeCurrent(window->egl_display,
+                       EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       EGL_NO_CONTEXT);
+        eglDestroyContext(window->egl_display, window->context);
+        if (window->surface != EGL_NO_SURFACE)
+                eglDestroySurface(window->egl_display, window->surface);
+        free(window);
+}
+
+const struct mct_window_backend
+mct_window_backend_egl = {
+        .open_display = open_display,
+        .close_display = close_display,
+        .init_thread = init_thread,
+        .release_current = release_current,
+        .window_new = window_new,
+        .window_show = window_show,
+        .window_make_current = window_make_current,
+        .window_swap = window_swap,
+        .window_set_swap_interval = window_set_swap_interval,
+        .window_free = window_free,
+};
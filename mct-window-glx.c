@@ -0,0 +1,478 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ * Authors:
+ *    Neil Roberts <neil@linux.intel.com>
+ *
+ */
+
+
+#include "config.h"
+
+#include <epoxy/gl.h>
+#include <GL/gl.h>
+#include <GL/glx.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mct-window-private.h"
+
+#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_ARB
+#define GLX_CONTEXT_RELEASE_BEHAVIOR_ARB  0x2097
+#endif
+#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB
+#define GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB 0
+#endif
+#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB
+#define GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB 0x2098
+#endif
+#ifndef GLX_RENDERER_VIDEO_MEMORY_MESA
+#define GLX_RENDERER_VIDEO_MEMORY_MESA 0x8187
+#endif
+
+typedef Bool
+(* mct_query_current_renderer_integer_func)(int attribute,
+                                            unsigned int *value);
+
+struct mct_display_glx {
+        struct mct_display base;
+        Display *display;
+};
+
+struct mct_window_glx {
+        struct mct_window base;
+        Display *display;
+        /* Both are None if the window is surfaceless */
+        Window win;
+        GLXContext context;
+        GLXWindow glx_window;
+
+        /* NULL if GLX_OML_sync_control isn't available */
+        PFNGLXGETSYNCVALUESOMLPROC get_sync_values;
+        PFNGLXWAITFORSBCOMLPROC wait_for_sbc;
+};
+
+static bool
+check_glx_extension(Display *display, const char *ext_name)
+{
+        int ext_len = strlen(ext_name);
+        const char *extensions =
+                glXQueryExtensionsString(display, DefaultScreen(display));
+        const char *extensions_end;
+
+        extensions_end = extensions + strlen(extensions);
+
+        while (extensions < extensions_end) {
+                const char *end = strchr(extensions, ' ');
+
+                if (end == NULL)
+                        end = extensions_end;
+
+                if (end - extensions == ext_len &&
+                    !memcmp(extensions, ext_name, ext_len))
+                        return true;
+
+                extensions = end + 1;
+        }
+
+        return false;
+}
+
+static GLXFBConfig
+choose_fb_config(Display *display)
+{
+        GLXFBConfig *configs;
+        int n_configs;
+        GLXFBConfig ret;
+        static const int attrib_list[] = {
+                GLX_DOUBLEBUFFER, True,
+                0
+        };
+
+        configs = glXChooseFBConfig(display, DefaultScreen(display),
+                                    attrib_list, &n_configs);
+
+        if (configs == NULL) {
+                ret = NULL;
+        } else {
+                if (n_configs < 1)
+                        ret = NULL;
+                else
+                        ret = configs[0];
+
+                XFree(configs);
+        }
+
+        return ret;
+}
+
+static struct mct_display *
+open_display(void)
+{
+        struct mct_display_glx *display;
+        Display *xdpy;
+
+        /* The threaded mode makes windows current on several
+         * threads at once */
+        XInitThreads();
+
+        xdpy = XOpenDisplay(NULL);
+
+        if (xdpy == NULL) {
+                fprintf(stderr, "XOpenDisplay failed\n");
+                return NULL;
+        }
+
+        display = malloc(sizeof *display);
+        display->display = xdpy;
+
+        return &display->base;
+}
+
+static void
+close_display(struct mct_display *base)
+{
+        struct mct_display_glx *display = (struct mct_display_glx *) base;
+
+        XCloseDisplay(display->display);
+        free(display);
+}
+
+static void
+init_thread(struct mct_display *base)
+{
+}
+
+static void
+release_current(struct mct_display *base)
+{
+        struct mct_display_glx *display = (struct mct_display_glx *) base;
+
+        glXMakeCurrent(display->display, None, NULL);
+}
+
+static void
+window_make_current(struct mct_window *base)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+
+        /* A GL 3.0 context can be bound without any drawable with
+         * GLX_ARB_create_context */
+        glXMakeContextCurrent(window->display,
+                              window->glx_window,
+                              window->glx_window,
+                              window->context);
+}
+
+static void
+window_swap(struct mct_window *base)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+
+        if (window->glx_window != None)
+                glXSwapBuffers(window->display, window->glx_window);
+}
+
+static void
+window_show(struct mct_window *base)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+
+        if (window->win != None)
+                XMapWindow(window->display, window->win);
+}
+
+static struct mct_window *
+window_new(struct mct_display *base_display,
+           int width, int height,
+           bool flush_on_release,
+           bool surfaceless,
+           struct mct_window *share_window)
+{
+        struct mct_display_glx *glx_display =
+                (struct mct_display_glx *) base_display;
+        Display *display = glx_display->display;
+        int context_attribs[] = {
+                GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
+                GLX_CONTEXT_MINOR_VERSION_ARB, 3,
+                GLX_CONTEXT_PROFILE_MASK_ARB,
+                GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+                GLX_CONTEXT_FLAGS_ARB,
+                GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+                GLX_CONTEXT_RELEASE_BEHAVIOR_ARB,
+                GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB,
+                None
+        };
+        GLXFBConfig fb_config;
+        GLXContext ctx, share_context = NULL;
+        int scrnum = 0;
+        XSetWindowAttributes attr;
+        unsigned long mask;
+        Window root;
+        XVisualInfo *visinfo;
+        struct mct_window_glx *window;
+        PFNGLXCREATECONTEXTATTRIBSARBPROC create_context_attribs;
+        bool has_flush_ext;
+
+        if (!check_glx_extension(display, "GLX_ARB_create_context")) {
+                fprintf(stderr,
+                        "GLX_ARB_create_context is not supported\n");
+                return NULL;
+        }
+
+        has_flush_ext = check_glx_extension(display,
+                                            "GLX_ARB_context_flush_control");
+
+        if (flush_on_release) {
+                if (has_flush_ext) {
+                        context_attribs[sizeof context_attribs /
+                                        sizeof context_attribs[0] - 2] =
+                                GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB;
+                } else {
+                        context_attribs[sizeof context_attribs /
+                                        sizeof context_attribs[0] - 3] = None;
+                }
+        } else if (!has_flush_ext) {
+                fprintf(stderr,
+                        "Requested disabling flush on release but "
+                        "GLX_ARB_context_flush_control is not "
+                        "available\n");
+                return NULL;
+        }
+
+        fb_config = choose_fb_config(display);
+
+        if (fb_config == NULL) {
+                fprintf(stderr,
+                        "No suitable GLXFBConfig found\n");
+                return NULL;
+        }
+
+        visinfo = glXGetVisualFromFBConfig(display, fb_config);
+
+        if (visinfo == NULL) {
+                fprintf(stderr,
+                         "FB config does not have an associated visual\n");
+                return NULL;
+        }
+
+        if (share_window) {
+                share_context =
+                        ((struct mct_window_glx *) share_window)->context;
+        }
+
+        create_context_attribs =
+                (void *) glXGetProcAddress((const GLubyte *)
+                                           "glXCreateContextAttribsARB");
+        ctx = create_context_attribs(display,
+                                     fb_config,
+                                     share_context,
+                                     True, /* direct */
+                                     context_attribs);
+
+        if (ctx == NULL) {
+                fprintf(stderr,
+                        "Error: glXCreateContextAttribs failed\n");
+                return NULL;
+        }
+
+        window = malloc(sizeof *window);
+
+        window->context = ctx;
+        window->display = display;
+        window->get_sync_values = NULL;
+        window->wait_for_sbc = NULL;
+
+        /* Skipping the X window also skips its colormap, which is
+         * most of the cost of creating a context */
+        if (surfaceless) {
+                XFree(visinfo);
+                window->win = None;
+                window->glx_window = None;
+                return &window->base;
+        }
+
+        root = RootWindow(display, scrnum);
+
+        /* window attributes */
+        attr.background_pixel = 0;
+        attr.border_pixel = 0;
+        attr.colormap =
+            XCreateColormap(display, root, visinfo->visual, AllocNone);
+        attr.event_mask =
+            StructureNotifyMask | ExposureMask | PointerMotionMask |
+            KeyPressMask;
+        mask = CWBorderPixel | CWColormap | CWEventMask;
+
+        window->win = XCreateWindow(display, root, 0, 0, width, height,
+                                    0, visinfo->depth, InputOutput,
+                                    visinfo->visual, mask, &attr);
+
+        window->glx_window = glXCreateWindow(display, fb_config,
+                                             window->win, NULL);
+
+        XFree(visinfo);
+
+        if (check_glx_extension(display, "GLX_OML_sync_control")) {
+                window->get_sync_values =
+                        (void *) glXGetProcAddress((const GLubyte *)
+                                                   "glXGetSyncValuesOML");
+                window->wait_for_sbc =
+                        (void *) glXGetProcAddress((const GLubyte *)
+                                                   "glXWaitForSbcOML");
+        }
+
+        return &window->base;
+}
+
+static void
+window_set_swap_interval(struct mct_window *base,
+                         int interval)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+        PFNGLXSWAPINTERVALMESAPROC swap_interval_mesa;
+        PFNGLXSWAPINTERVALMESAPROC swap_interval_sgi;
+
+        /* The swap interval belongs to the drawable */
+        if (window->glx_window == None)
+                return;
+
+        if (check_glx_extension(window->display, "GLX_MESA_swap_control")) {
+                swap_interval_mesa =
+                        (void *) glXGetProcAddress((const GLubyte *)
+                                                   "glXSwapIntervalMESA");
+                if (swap_interval_mesa(interval) == 0)
+                        return;
+        }
+
+        /* Try with the SGI extension. Technically this shouldn't work
+         * because the spec disallows swap interval 0 */
+        if (check_glx_extension(window->display, "GLX_SGI_swap_control")) {
+                swap_interval_sgi =
+                        (void *) glXGetProcAddress((const GLubyte *)
+                                                   "glXSwapIntervalSGI");
+                if (swap_interval_sgi(interval) == 0)
+                        return;
+        }
+
+        fprintf(stderr,
+                "note: failed to set swap interval to %i with either "
+                "GLX_MESA_swap_control or GLX_SGI_swap_control\n",
+                interval);
+}
+
+static bool
+window_get_swap_count(struct mct_window *base,
+                      int64_t *count)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+        int64_t ust, msc;
+
+        if (window->get_sync_values == NULL)
+                return false;
+
+        return window->get_sync_values(window->display,
+                                       window->glx_window,
+                                       &ust, &msc, count);
+}
+
+static bool
+window_get_swap_time(struct mct_window *base,
+                     int64_t swap_count,
+                     uint64_t *time,
+                     int64_t *vblank_count)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+        int64_t ust, sbc;
+
+        /* The swap has already completed so this doesn't block, but
+         * the UST and MSC are those of the most recent swap so they
+         * only belong to this one if nothing else has completed since.
+         * The UST is in microseconds on CLOCK_MONOTONIC with Mesa. */
+        if (!window->wait_for_sbc(window->display,
+                                  window->glx_window,
+                                  swap_count,
+                                  &ust, vblank_count, &sbc) ||
+            sbc != swap_count)
+                return false;
+
+        *time = ust * 1000;
+
+        return true;
+}
+
+static bool
+window_get_video_memory(struct mct_window *base,
+                        long *size)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+        mct_query_current_renderer_integer_func query_integer;
+        unsigned int value;
+
+        if (!check_glx_extension(window->display, "GLX_MESA_query_renderer"))
+                return false;
+
+        query_integer =
+                (void *) glXGetProcAddress((const GLubyte *)
+                                           "glXQueryCurrentRendererIntegerMESA");
+
+        /* The value is in megabytes */
+        if (query_integer == NULL ||
+            !query_integer(GLX_RENDERER_VIDEO_MEMORY_MESA, &value))
+                return false;
+
+        *size = value * 1024L;
+
+        return true;
+}
+
+static void
+window_free(struct mct_window *base)
+{
+        struct mct_window_glx *window = (struct mct_window_glx *) base;
+
+        glXDestroyContext(window->display, window->context);
+        if (window->glx_window != None) {
+                glXDestroyWindow(window->display, window->glx_window);
+                XDestroyWindow(window->display, window->win);
+        }
+        free(window);
+}
+
+const struct mct_window_backend
+mct_window_backend_glx = {
+        .open_display = open_display,
+        .close_display = close_display,
+        .init_thread = init_thread,
+        .release_current = release_current,
+        .window_new = window_new,
+        .window_show = window_show,
+        .window_make_current = window_make_current,
+        .window_swap = window_swap,
+        .window_set_swap_interval = window_set_swap_interval,
+        .window_free = window_free,
+        .window_get_swap_count = window_get_swap_count,
+        .window_get_swap_time = window_get_swap_time,
+        .window_get_video_memory = window_get_video_memory,
+};
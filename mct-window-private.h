@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_WINDOW_PRIVATE_H
+#define MCT_WINDOW_PRIVATE_H
+
+#include "mct-window.h"
+
+/* Each platform backend embeds these structs at the start of its own
+ * display and window structs and fills in a vtable so that the rest
+ * of the program doesn't need to know which window system is in
+ * use. */
+
+struct mct_window_backend {
+        struct mct_display *
+        (* open_display)(void);
+
+        void
+        (* close_display)(struct mct_display *display);
+
+        void
+        (* init_thread)(struct mct_display *display);
+
+        void
+        (* release_current)(struct mct_display *display);
+
+        struct mct_window *
+        (* window_new)(struct mct_display *display,
+                       int width, int height,
+                       bool flush_on_release,
+                       bool surfaceless,
+                       struct mct_window *share_window);
+
+        void
+        (* window_show)(struct mct_window *window);
+
+        void
+        (* window_make_current)(struct mct_window *window);
+
+        void
+        (* window_swap)(struct mct_window *window);
+
+        void
+        (* window_set_swap_interval)(struct mct_window *window,
+                                     int interval);
+
+        void
+        (* window_free)(struct mct_window *window);
+
+        /* These are optional and are used to measure when swaps are
+         * actually presented. get_swap_count returns the number of
+         * swaps that have completed on the window without blocking.
+         * get_swap_time is only called for the most recent swap that
+         * has completed and returns its presentation time in
+         * nanoseconds on the same clock as mct_get_time_ns and the
+         * vblank counter. It returns false if it can't give the
+         * timing of that exact swap, for example because another one
+         * completed in the meantime. */
+        bool
+        (* window_get_swap_count)(struct mct_window *window,
+                                  int64_t *count);
+
+        bool
+        (* window_get_swap_time)(struct mct_window *window,
+                                 int64_t swap_count,
+                                 uint64_t *time,
+                                 int64_t *vblank_count);
+
+        /* Optional. Returns the video memory in kilobytes for the
+         * current context. */
+        bool
+        (* window_get_video_memory)(struct mct_window *window,
+                                    long *size);
+};
+
+struct mct_display {
+        const struct mct_window_backend *backend;
+
+        /* Updated atomically because several threads can make
+         * windows current at once */
+        bool make_current_cache;
+};
+
+#define MCT_PRESENT_QUEUE_SIZE 16
+
+struct mct_pending_swap {
+        uint64_t submit_time;
+        int64_t swap_count;
+};
+
+/* Swaps that haven't been presented yet */
+struct mct_present_state {
+        struct mct_pending_swap queue[MCT_PRESENT_QUEUE_SIZE];
+        int queue_start;
+        int queue_length;
+
+        /* Value of the swap count after the last swap submitted */
+        int64_t swap_count;
+        /* Swap count and vblank counter of the last swap that was
+         * timed. The vblank counter is -1 if there isn't one. */
+        int64_t last_swap_count;
+        int64_t last_vblank_count;
+
+        struct mct_present_stats stats;
+};
+
+struct mct_window {
+        struct mct_display *display;
+
+        int swap_interval;
+
+        /* NULL unless presentation timing is enabled */
+        struct mct_present_state *present;
+};
+
+extern const struct mct_window_backend
+mct_window_backend_glx;
+
+#ifdef HAVE_EGL
+extern const struct mct_window_backend
+mct_window_backend_egl;
+#endif
+
+#endif /* MCT_WINDOW_PRIVATE_H */
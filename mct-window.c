@@ -0,0 +1,373 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mct-window-private.h"
+
+/* The window that was last made current on this thread with
+ * mct_window_make_current or NULL if it isn't known */
+static __thread struct mct_window *current_window = NULL;
+/* Kept per thread so that counting doesn't add any shared cache line
+ * traffic to the make-current calls that are being measured */
+static __thread struct mct_make_current_stats make_current_stats;
+
+static const struct {
+        const char *name;
+        enum mct_platform platform;
+} platform_names[] = {
+        { "glx", MCT_PLATFORM_GLX },
+        { "egl", MCT_PLATFORM_EGL },
+};
+
+bool
+mct_platform_from_string(const char *name,
+                         enum mct_platform *platform)
+{
+        int i;
+
+        for (i = 0; i < sizeof platform_names / sizeof platform_names[0]; i++) {
+                if (!strcmp(platform_names[i].name, name)) {
+                        *platform = platform_names[i].platform;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+const char *
+mct_platform_to_string(enum mct_platform platform)
+{
+        int i;
+
+        for (i = 0; i < sizeof platform_names / sizeof platform_names[0]; i++) {
+                if (platform_names[i].platform == platform)
+                        return platform_names[i].name;
+        }
+
+        return "?";
+}
+
+struct mct_display *
+mct_display_open(enum mct_platform platform)
+{
+        const struct mct_window_backend *backend;
+        struct mct_display *display;
+
+        switch (platform) {
+        case MCT_PLATFORM_GLX:
+                backend = &mct_window_backend_glx;
+                break;
+        case MCT_PLATFORM_EGL:
+#ifdef HAVE_EGL
+                backend = &mct_window_backend_egl;
+                break;
+#else
+                fprintf(stderr,
+                        "multi-context-test was built without EGL support\n");
+                return NULL;
+#endif
+        default:
+                return NULL;
+        }
+
+        display = backend->open_display();
+
+        if (display) {
+                display->backend = backend;
+                display->make_current_cache = false;
+        }
+
+        return display;
+}
+
+void
+mct_display_close(struct mct_display *display)
+{
+        display->backend->close_display(display);
+}
+
+void
+mct_display_init_thread(struct mct_display *display)
+{
+        display->backend->init_thread(display);
+}
+
+void
+mct_display_release_current(struct mct_display *display)
+{
+        display->backend->release_current(display);
+        current_window = NULL;
+}
+
+void
+mct_display_set_make_current_cache(struct mct_display *display,
+                                   bool enabled)
+{
+        display->make_current_cache = enabled;
+}
+
+void
+mct_window_get_thread_make_current_stats(struct mct_make_current_stats *stats)
+{
+        *stats = make_current_stats;
+}
+
+struct mct_window *
+mct_window_new(struct mct_display *display,
+               int width, int height,
+               bool flush_on_release,
+               bool surfaceless,
+               struct mct_window *share_window)
+{
+        struct mct_window *window;
+
+        window = display->backend->window_new(display,
+                                              width, height,
+                                              flush_on_release,
+                                              surfaceless,
+                                              share_window);
+
+        if (window) {
+                window->display = display;
+                window->swap_interval = 1;
+                window->present = NULL;
+        }
+
+        return window;
+}
+
+void
+mct_window_show(struct mct_window *window)
+{
+        window->display->backend->window_show(window);
+}
+
+void
+mct_window_make_current(struct mct_window *window)
+{
+        struct mct_display *display = window->display;
+
+        make_current_stats.calls++;
+
+        if (window == current_window) {
+                make_current_stats.redundant++;
+
+                if (display->make_current_cache) {
+                        make_current_stats.elided++;
+                        return;
+                }
+        }
+
+        display->backend->window_make_current(window);
+        current_window = window;
+}
+
+bool
+mct_window_is_current(struct mct_window *window)
+{
+        return window == current_window;
+}
+
+struct mct_window *
+mct_window_get_current(void)
+{
+        return current_window;
+}
+
+static void
+collect_presented_swaps(struct mct_window *window)
+{
+        const struct mct_window_backend *backend = window->display->backend;
+        struct mct_present_state *present = window->present;
+        struct mct_pending_swap *swap;
+        int64_t swap_count, vblank_count, vblanks, expected;
+        uint64_t time;
+
+        if (present->queue_length <= 0 ||
+            !backend->window_get_swap_count(window, &swap_count))
+                return;
+
+        while (present->queue_length > 0) {
+                swap = present->queue + present->queue_start;
+
+                if (swap->swap_count > swap_count)
+                        break;
+
+                present->queue_start = ((present->queue_start + 1) %
+                                        MCT_PRESENT_QUEUE_SIZE);
+                present->queue_length--;
+
+                /* Only the most recent swap can be timed. The older
+                 * ones would get its timestamp. */
+                if (swap->swap_count < swap_count ||
+                    !backend->window_get_swap_time(window,
+                                                   swap->swap_count,
+                                                   &time,
+                                                   &vblank_count)) {
+                        present->stats.dropped++;
+                        continue;
+                }
+
+                mct_histogram_add(&present->stats.latency,
+                                  time > swap->submit_time ?
+                                  time - swap->submit_time :
+                                  0);
+
+                /* With a swap interval of zero frames can be
+                 * presented at any time so nothing is missed. Any
+                 * swaps in between that weren't timed each account
+                 * for a swap interval too. */
+                if (present->last_vblank_count >= 0 &&
+                    window->swap_interval > 0) {
+                        vblanks = vblank_count - present->last_vblank_count;
+                        expected = (window->swap_interval *
+                                    (swap->swap_count -
+                                     present->last_swap_count));
+                        if (vblanks > expected) {
+                                present->stats.missed_vblanks +=
+                                        vblanks - expected;
+                        }
+                }
+
+                present->last_swap_count = swap->swap_count;
+                present->last_vblank_count = vblank_count;
+        }
+}
+
+static void
+queue_swap(struct mct_window *window,
+           uint64_t submit_time)
+{
+        struct mct_present_state *present = window->present;
+        struct mct_pending_swap *swap;
+
+        collect_presented_swaps(window);
+
+        if (present->queue_length >= MCT_PRESENT_QUEUE_SIZE) {
+                present->queue_start = ((present->queue_start + 1) %
+                                        MCT_PRESENT_QUEUE_SIZE);
+                present->queue_length--;
+                present->stats.dropped++;
+        }
+
+        swap = present->queue + ((present->queue_start +
+                                  present->queue_length) %
+                                 MCT_PRESENT_QUEUE_SIZE);
+        swap->submit_time = submit_time;
+        swap->swap_count = ++present->swap_count;
+        present->queue_length++;
+}
+
+void
+mct_window_swap(struct mct_window *window)
+{
+        uint64_t submit_time = 0;
+
+        mct_window_make_current(window);
+
+        if (window->present)
+                submit_time = mct_get_time_ns();
+
+        window->display->backend->window_swap(window);
+
+        if (window->present)
+                queue_swap(window, submit_time);
+}
+
+void
+mct_window_set_swap_interval(struct mct_window *window,
+                             int interval)
+{
+        window->swap_interval = interval;
+        window->display->backend->window_set_swap_interval(window, interval);
+}
+
+bool
+mct_window_enable_present_timing(struct mct_window *window)
+{
+        const struct mct_window_backend *backend = window->display->backend;
+        struct mct_present_state *present;
+        int64_t swap_count;
+
+        if (window->present)
+                return true;
+
+        if (backend->window_get_swap_count == NULL ||
+            !backend->window_get_swap_count(window, &swap_count))
+                return false;
+
+        present = malloc(sizeof *present);
+        present->queue_start = 0;
+        present->queue_length = 0;
+        present->swap_count = swap_count;
+        present->last_swap_count = swap_count;
+        present->last_vblank_count = -1;
+        mct_histogram_init(&present->stats.latency);
+        present->stats.missed_vblanks = 0;
+        present->stats.dropped = 0;
+
+        window->present = present;
+
+        return true;
+}
+
+const struct mct_present_stats *
+mct_window_get_present_stats(struct mct_window *window)
+{
+        if (window->present == NULL)
+                return NULL;
+
+        collect_presented_swaps(window);
+
+        return &window->present->stats;
+}
+
+bool
+mct_window_get_video_memory(struct mct_window *window,
+                            long *size)
+{
+        const struct mct_window_backend *backend = window->display->backend;
+
+        if (backend->window_get_video_memory == NULL)
+                return false;
+
+        return backend->window_get_video_memory(window, size);
+}
+
+void
+mct_window_free(struct mct_window *window)
+{
+        free(window->present);
+
+        window->display->backend->window_free(window);
+
+        /* The backend might unbind whatever was current */
+        current_window = NULL;
+}
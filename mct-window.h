@@ -0,0 +1,151 @@
+/*
+ * Copyright © 2026 The multi-context-test contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+#ifndef MCT_WINDOW_H
+#define MCT_WINDOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mct-timing.h"
+
+enum mct_platform {
+        MCT_PLATFORM_GLX,
+        MCT_PLATFORM_EGL
+};
+
+struct mct_display;
+struct mct_window;
+
+struct mct_present_stats {
+        /* Time in nanoseconds from calling mct_window_swap until the
+         * frame reached the screen */
+        struct mct_histogram latency;
+        /* Extra vblanks that passed between two presented frames
+         * beyond the swap interval */
+        uint64_t missed_vblanks;
+        /* Swaps that were never timed, either because too many were
+         * still waiting to be presented or because a later swap had
+         * already completed by the time they were checked so their
+         * own presentation time was no longer available */
+        uint64_t dropped;
+};
+
+struct mct_make_current_stats {
+        /* Calls to mct_window_make_current, including the ones made
+         * by mct_window_swap */
+        uint64_t calls;
+        /* Calls where the window was already current on the thread */
+        uint64_t redundant;
+        /* Redundant calls that weren't passed on to the window
+         * system because the cache is enabled */
+        uint64_t elided;
+};
+
+bool
+mct_platform_from_string(const char *name,
+                         enum mct_platform *platform);
+
+const char *
+mct_platform_to_string(enum mct_platform platform);
+
+struct mct_display *
+mct_display_open(enum mct_platform platform);
+
+void
+mct_display_close(struct mct_display *display);
+
+/* Must be called on each thread before it makes a window current */
+void
+mct_display_init_thread(struct mct_display *display);
+
+/* Unbinds whatever context is current on the calling thread */
+void
+mct_display_release_current(struct mct_display *display);
+
+/* The window that is current on each thread is always tracked. If
+ * the cache is enabled then making it current again does nothing.
+ * It is disabled by default. */
+void
+mct_display_set_make_current_cache(struct mct_display *display,
+                                   bool enabled);
+
+/* Gets the counters of the calling thread since it started. Other
+ * threads have to pass theirs on to be summed. */
+void
+mct_window_get_thread_make_current_stats(struct mct_make_current_stats *stats);
+
+/* If share_window is not NULL the new context will be in the same
+ * share group as its context. A surfaceless window is only a context
+ * without any drawable so it can only draw to framebuffer objects and
+ * swapping it does nothing. */
+struct mct_window *
+mct_window_new(struct mct_display *display,
+               int width, int height,
+               bool flush_on_release,
+               bool surfaceless,
+               struct mct_window *share_window);
+
+void
+mct_window_show(struct mct_window *window);
+
+void
+mct_window_make_current(struct mct_window *window);
+
+/* Whether the window was the last one made current on this thread */
+bool
+mct_window_is_current(struct mct_window *window);
+
+/* The window that was last made current on this thread or NULL */
+struct mct_window *
+mct_window_get_current(void);
+
+void
+mct_window_swap(struct mct_window *window);
+
+void
+mct_window_set_swap_interval(struct mct_window *window,
+                             int interval);
+
+/* Starts measuring when each swap is presented. Returns false if the
+ * window system can't report it, for example with Xvfb or EGL
+ * pbuffers. */
+bool
+mct_window_enable_present_timing(struct mct_window *window);
+
+/* Returns NULL unless presentation timing is enabled */
+const struct mct_present_stats *
+mct_window_get_present_stats(struct mct_window *window);
+
+/* Gets the total video memory in kilobytes from
+ * GLX_MESA_query_renderer. The window must be current. Returns false
+ * if the window system can't report it. */
+bool
+mct_window_get_video_memory(struct mct_window *window,
+                            long *size);
+
+void
+mct_window_free(struct mct_window *window);
+
+#endif /* MCT_WINDOW_H */
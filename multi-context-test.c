@@ -29,22 +29,33 @@
 
 #include <epoxy/gl.h>
 #include <stdbool.h>
-#include <GL/gl.h>
-#include <GL/glx.h>
+#include <stddef.h>
 #include <string.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <sys/time.h>
+#include <pthread.h>
+#include <errno.h>
+#include <limits.h>
 #include <time.h>
-
+#include <signal.h>
+#include <unistd.h>
+
+#include "mct-window.h"
+#include "mct-config.h"
+#include "mct-draw-state.h"
+#include "mct-report.h"
+#include "mct-timing.h"
+#include "mct-memory.h"
+#include "mct-stats.h"
+#include "mct-perf.h"
+#include "mct-trace.h"
+#include "mct-baseline.h"
+#include "mct-process.h"
+#include "mct-pool.h"
 #include "shader-data.h"
 
-#define GRID_WIDTH 100
-#define GRID_HEIGHT 100
-
-#define N_WINDOWS 3
-
 #ifndef GL_CONTEXT_RELEASE_BEHAVIOR
 #define GL_CONTEXT_RELEASE_BEHAVIOR       0x82FB
 #endif
@@ -52,535 +63,3486 @@
 #define GL_CONTEXT_RELEASE_BEHAVIOR_FLUSH 0x82FC
 #endif
 
-#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_ARB
-#define GLX_CONTEXT_RELEASE_BEHAVIOR_ARB  0x2097
-#endif
-#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB
-#define GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB 0
-#endif
-#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB
-#define GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB 0x2098
-#endif
+#define DEFAULT_SWEEP_DURATION 5.0
+#define DEFAULT_COMPARE_DURATION 10.0
+#define DEFAULT_COMPARE_BLOCKS 20
+#define DEFAULT_COMPARE_WARMUP 1.0
+#define COMPARE_CONFIDENCE 0.95
+/* About 6MB of trace for each thread */
+#define TRACE_EVENTS_PER_THREAD (1 << 18)
+#define DEFAULT_REGRESSION_THRESHOLD 5.0
+/* Exit status when a run is slower than the baseline */
+#define EXIT_REGRESSION 2
+
+struct mct_context_state {
+        int id;
+        struct mct_window *window;
+        struct mct_draw_state *draw_state;
 
-struct mct_window {
-        Display *display;
-        Window win;
-        GLXContext context;
-        GLXWindow glx_window;
+        /* Total time spent making this context current */
+        uint64_t make_current_time;
+        struct mct_perf_values make_current_perf;
 };
 
-struct mct_draw_state {
-        GLuint grid_buffer;
-        GLuint grid_array;
+enum mct_phase {
+        MCT_PHASE_START,
+        MCT_PHASE_DRAW,
+        MCT_PHASE_END,
+        MCT_PHASE_FRAME,
+        MCT_N_PHASES
+};
 
-        GLuint prog;
+static const char * const
+phase_names[MCT_N_PHASES] = {
+        [MCT_PHASE_START] = "start",
+        [MCT_PHASE_DRAW] = "draw",
+        [MCT_PHASE_END] = "end",
+        [MCT_PHASE_FRAME] = "frame",
+};
 
-        GLuint band_pos_location;
+/* Timings in nanoseconds. The start phase covers making each context
+ * current and setting up its state, the draw phase is the
+ * row-interleaved drawing and the end phase includes the swaps. */
+struct mct_frame_stats {
+        struct mct_histogram phases[MCT_N_PHASES];
+        struct mct_histogram make_current;
+        /* Time spent making a window current that already was */
+        uint64_t redundant_make_current_time;
+
+        /* CPU counters for the thread or NULL if they are disabled */
+        struct mct_perf *perf;
+        /* Counter totals over all frames. The frame phase is the
+         * whole frame. */
+        struct mct_perf_values phase_perf[MCT_N_PHASES];
+        struct mct_perf_values make_current_perf;
 };
 
-struct mct_context_state {
-        struct mct_window *window;
-        struct mct_draw_state *draw_state;
+/* Points where the memory is sampled when config->memory is set.
+ * The grid is part of the draw state. Steady is the growth from the
+ * end of the initialization to the end of the run. */
+enum mct_memory_stage {
+        MCT_MEMORY_WINDOW,
+        MCT_MEMORY_DRAW_STATE,
+        MCT_MEMORY_GRID,
+        MCT_MEMORY_STEADY,
+        MCT_N_MEMORY_STAGES
 };
 
-struct mct_vertex {
-        float x, y;
+static const char * const
+memory_stage_names[MCT_N_MEMORY_STAGES] = {
+        [MCT_MEMORY_WINDOW] = "window",
+        [MCT_MEMORY_DRAW_STATE] = "draw_state",
+        [MCT_MEMORY_GRID] = "grid",
+        [MCT_MEMORY_STEADY] = "steady",
 };
 
-static bool
-check_glx_extension(Display *display, const char *ext_name)
-{
-        int ext_len = strlen(ext_name);
-        const char *extensions =
-                glXQueryExtensionsString(display, DefaultScreen(display));
-        const char *extensions_end;
+struct mct_run;
+
+/* In threaded mode each context is permanently bound to one of these
+ * threads. The threads are kept in lockstep with a pair of barriers
+ * around each frame. The quit flag is only written while the workers
+ * are between the end barrier and the next start barrier so they
+ * always see a consistent value. */
+struct mct_worker {
+        pthread_t thread;
+        struct mct_run *run;
+        struct mct_context_state *context_state;
+        struct mct_frame_stats stats;
+        /* Copy of the thread's counters. It is only written while
+         * the main thread is waiting so it can be read between
+         * frames. */
+        struct mct_make_current_stats make_current_stats;
+};
+
+struct mct_run {
+        struct mct_display *display;
+        struct mct_config *config;
+        struct mct_context_state *context_states;
+        struct mct_frame_stats *stats;
+
+        /* Cost of creating the contexts */
+        uint64_t init_time;
+        long init_rss;
+        struct shader_data_cache_stats cache_stats;
+
+        /* Only filled in if config->memory is set */
+        struct mct_memory_usage memory[MCT_N_MEMORY_STAGES];
+        /* Before creating any contexts and after the initialization */
+        struct mct_memory_sample start_memory;
+        struct mct_memory_sample init_memory;
+
+        /* Only used in pool mode. The tenants only have a window and
+         * a draw state while they own one of the pool's contexts. */
+        struct mct_pool *pool;
+        /* Time to build a tenant's draw state in its context */
+        struct mct_histogram *state_init_time;
+        /* Results of the draw states that were freed because their
+         * context was recycled */
+        struct mct_readback_stats evicted_readback_stats;
+
+        /* The rest is only used in threaded mode */
+        struct mct_worker *workers;
+        pthread_barrier_t start_barrier;
+        pthread_barrier_t end_barrier;
+        bool quit;
+};
+
+/* Settings shared by all of the runs */
+struct mct_session {
+        struct mct_display *display;
+        enum mct_platform platform;
+        struct mct_report *report;
+
+        /* Limits for each run. If neither is set then the run
+         * continues until it is interrupted. */
+        double duration;
+        long long max_frames;
+
+        /* Results to compare the frame rates against or NULL */
+        struct mct_baseline *baseline;
+        /* Percentage below the baseline that counts as a
+         * regression */
+        double threshold;
+        int n_runs;
+        int n_regressions;
+        int n_missing_baselines;
+};
+
+/* Shared between the main process and the workers in process mode */
+struct mct_process_worker {
+        /* Written by the worker */
+        volatile int ready;
+        volatile int done;
+        volatile long long frame_count;
+        uint64_t start_time;
+        uint64_t end_time;
+        /* Per-context frame times */
+        struct mct_frame_stats stats;
+        struct mct_readback_stats readback_stats;
+};
+
+struct mct_process_control {
+        enum mct_platform platform;
+        struct mct_config config;
+        long long max_frames;
+
+        /* Written by the main process */
+        volatile int start;
+        volatile int stop;
+
+        struct mct_process_worker workers[];
+};
+
+#define PROCESS_WORKER_OPTION "process-worker"
+
+/* Set by SIGINT or SIGTERM to finish the current run early and skip
+ * the rest */
+static volatile sig_atomic_t interrupted;
+
+struct mct_axis_name {
+        const char *name;
+        int value;
+};
 
-        extensions_end = extensions + strlen(extensions);
+/* Each member of struct mct_config can be given a list of values on
+ * the command line. If any of them has more than one value then every
+ * combination is run and reported as a separate record. */
+struct mct_axis {
+        const char *name;
+        size_t offset;
+        /* NULL if the values are plain integers */
+        const struct mct_axis_name *names;
+        int min_value;
+        int default_value;
+        const char *help;
+
+        int n_values;
+        int *values;
+        /* Whether the values were given on the command line */
+        bool given;
+};
+
+static const struct mct_axis_name
+release_names[] = {
+        { "none", false },
+        { "flush", true },
+        { NULL }
+};
+
+static const struct mct_axis_name
+bool_names[] = {
+        { "no", false },
+        { "yes", true },
+        { NULL }
+};
+
+static const struct mct_axis_name
+compile_names[] = {
+        { "serial", false },
+        { "parallel", true },
+        { NULL }
+};
+
+static const struct mct_axis_name
+grid_names[] = {
+        { "buffer", false },
+        { "procedural", true },
+        { NULL }
+};
+
+static const struct mct_axis_name
+target_names[] = {
+        { "window", MCT_TARGET_WINDOW },
+        { "fbo", MCT_TARGET_FBO },
+        { "surfaceless", MCT_TARGET_SURFACELESS },
+        { NULL }
+};
+
+static const struct mct_axis_name
+vertex_format_names[] = {
+        { "float", MCT_VERTEX_FORMAT_FLOAT },
+        { "half", MCT_VERTEX_FORMAT_HALF },
+        { "snorm16", MCT_VERTEX_FORMAT_SNORM16 },
+        { NULL }
+};
+
+static const struct mct_axis_name
+sync_names[] = {
+        { "none", MCT_SYNC_NONE },
+        { "flush", MCT_SYNC_FLUSH },
+        { "finish", MCT_SYNC_FINISH },
+        { "fence-server", MCT_SYNC_FENCE_SERVER },
+        { "fence-client", MCT_SYNC_FENCE_CLIENT },
+        { NULL }
+};
+
+static const struct mct_axis_name
+uniforms_names[] = {
+        { "plain", MCT_UNIFORMS_PLAIN },
+        { "ubo", MCT_UNIFORMS_UBO },
+        { "shared-ubo", MCT_UNIFORMS_SHARED_UBO },
+        { NULL }
+};
+
+static const struct mct_axis_name
+make_current_names[] = {
+        { "always", false },
+        { "cached", true },
+        { NULL }
+};
+
+static const struct mct_axis_name
+mode_names[] = {
+        { "single", MCT_MODE_SINGLE },
+        { "threaded", MCT_MODE_THREADED },
+        { "process", MCT_MODE_PROCESS },
+        { "pool", MCT_MODE_POOL },
+        { NULL }
+};
 
-        while (extensions < extensions_end) {
-                const char *end = strchr(extensions, ' ');
+#define AXIS(name, member, names, min_value, default_value, help)       \
+        { name, offsetof(struct mct_config, member),                    \
+          names, min_value, default_value, help }
+
+static struct mct_axis
+axes[] = {
+        AXIS("contexts", n_contexts, NULL, 1, 3,
+             "Number of contexts"),
+        AXIS("columns", grid_width, NULL, 1, 100,
+             "Number of quads in each row of the grid"),
+        AXIS("rows", grid_height, NULL, 1, 100,
+             "Number of rows in the grid. The rows of the contexts\n"
+             "are interleaved with a context switch after every\n"
+             "--batch rows"),
+        AXIS("grid", procedural_grid, grid_names, 0, false,
+             "Either store the grid positions in a vertex buffer or\n"
+             "generate them from gl_VertexID with no buffer at all"),
+        AXIS("vertex-format", vertex_format, vertex_format_names,
+             0, MCT_VERTEX_FORMAT_FLOAT,
+             "Type of the positions in the grid buffer"),
+        AXIS("stream", stream, bool_names, 0, false,
+             "Rewrite the grid every frame into a persistently mapped\n"
+             "triple-buffered ring with ARB_buffer_storage"),
+        AXIS("vertex-alu", vertex_alu, NULL, 0, 0,
+             "Iterations of a dependent ALU loop in the vertex shader"),
+        AXIS("fragment-alu", fragment_alu, NULL, 0, 0,
+             "Iterations of a dependent ALU loop in the fragment\n"
+             "shader. Sweep this with --release=none,flush to find\n"
+             "where the release behavior stops mattering"),
+        AXIS("overdraw", overdraw, NULL, 1, 1,
+             "Number of times each row is drawn on top of itself"),
+        AXIS("texture-samples", texture_samples, NULL, 0, 0,
+             "Number of texture fetches per fragment from a 256x256\n"
+             "noise texture"),
+        AXIS("uniforms", uniforms, uniforms_names, 0, MCT_UNIFORMS_PLAIN,
+             "How the per-frame state is uploaded. ubo gives each\n"
+             "context a std140 uniform buffer and shared-ubo uses one\n"
+             "buffer with a range per context, which needs the\n"
+             "contexts to be shared"),
+        AXIS("sync", sync, sync_names, 0, MCT_SYNC_NONE,
+             "Explicit synchronization between drawing with one context\n"
+             "and switching to the next in single mode. The fence\n"
+             "modes need --share=yes"),
+        AXIS("make-current", make_current_cache, make_current_names,
+             0, false,
+             "Whether to skip making a context current when it already\n"
+             "is on the thread"),
+        AXIS("swap-interval", swap_interval, NULL, 0, 0,
+             "Swap interval of each window. 0 disables vsync"),
+        AXIS("batch", rows_per_switch, NULL, 1, 1,
+             "Number of rows drawn after each context switch. The\n"
+             "rows are drawn with a single glMultiDrawArrays call"),
+        AXIS("width", width, NULL, 1, 640,
+             "Width of each window"),
+        AXIS("height", height, NULL, 1, 640,
+             "Height of each window"),
+        AXIS("target", target, target_names, 0, MCT_TARGET_WINDOW,
+             "Draw to the window or to a framebuffer object for each\n"
+             "context without swapping. surfaceless also draws to a\n"
+             "framebuffer object but the contexts have no window or\n"
+             "pbuffer at all"),
+        AXIS("release", flush_on_release, release_names, 0, true,
+             "Context release behavior"),
+        AXIS("mode", mode, mode_names, 0, MCT_MODE_SINGLE,
+             "Either switch between all of the contexts on one thread,\n"
+             "give each context its own render thread, give each\n"
+             "context its own process or draw each context's whole\n"
+             "frame in turn with a context from a pool that is\n"
+             "created lazily"),
+        AXIS("pool-size", pool_size, NULL, 0, 0,
+             "Maximum number of contexts in pool mode. Once they are\n"
+             "all in use the least recently used one is recycled for\n"
+             "the next context that draws. 0 means no limit. Sweep\n"
+             "--contexts=1,8,64,512 with --target=surfaceless to see\n"
+             "how the switching cost scales"),
+        AXIS("share", share, bool_names, 0, false,
+             "Put the contexts in one share group and create the grid\n"
+             "buffer and program only once"),
+        AXIS("compile", parallel_compile, compile_names, 0, true,
+             "Either compile the program for each context in turn or\n"
+             "submit them all before waiting. This uses\n"
+             "GL_KHR_parallel_shader_compile if available or a thread\n"
+             "per context otherwise"),
+};
 
-                if (end == NULL)
-                        end = extensions_end;
+#define N_AXES (sizeof axes / sizeof axes[0])
 
-                if (end - extensions == ext_len &&
-                    !memcmp(extensions, ext_name, ext_len))
-                        return true;
+static void
+destroy_contexts(struct mct_context_state *context_states,
+                 int n_contexts)
+{
+        int i;
 
-                extensions = end + 1;
+        for (i = n_contexts - 1; i >= 0; i--) {
+                mct_window_make_current(context_states[i].window);
+                if (context_states[i].draw_state)
+                        mct_draw_state_free(context_states[i].draw_state);
+                mct_window_free(context_states[i].window);
         }
+}
 
-        return false;
+static void
+sample_memory(struct mct_memory_sample *sample)
+{
+        /* The video memory can only be queried with a context */
+        mct_memory_sample(sample, mct_window_get_current() != NULL);
 }
 
-static GLXFBConfig
-choose_fb_config(Display *display)
+/* memory is NULL unless it should be sampled around creating the
+ * draw state */
+static bool
+init_draw_state(const struct mct_config *config,
+                struct mct_context_state *context_state,
+                struct mct_draw_state *share_state,
+                struct mct_memory_usage *memory)
 {
-        GLXFBConfig *configs;
-        int n_configs;
-        GLXFBConfig ret;
-        static const int attrib_list[] = {
-                GLX_DOUBLEBUFFER, True,
-                0
-        };
+        struct mct_memory_sample start, end;
 
-        configs = glXChooseFBConfig(display, DefaultScreen(display),
-                                    attrib_list, &n_configs);
+        mct_window_make_current(context_state->window);
 
-        if (configs == NULL) {
-                ret = NULL;
-        } else {
-                if (n_configs < 1)
-                        ret = NULL;
-                else
-                        ret = configs[0];
+        mct_window_set_swap_interval(context_state->window,
+                                     config->swap_interval);
+
+        if (memory)
+                sample_memory(&start);
 
-                XFree(configs);
+        context_state->draw_state = mct_draw_state_new(config, share_state);
+
+        if (context_state->draw_state == NULL)
+                return false;
+
+        if (memory) {
+                sample_memory(&end);
+                mct_memory_usage_add(memory + MCT_MEMORY_DRAW_STATE,
+                                     &start,
+                                     &end,
+                                     1 /* count */);
+                mct_memory_usage_merge(memory + MCT_MEMORY_GRID,
+                                       mct_draw_state_get_grid_memory(
+                                               context_state->draw_state));
         }
 
-        return ret;
+        return true;
 }
 
-static void
-mct_window_make_current(struct mct_window *window)
+static bool
+finish_draw_state(struct mct_context_state *context_state)
 {
-        glXMakeCurrent(window->display, window->glx_window, window->context);
+        if (mct_draw_state_finish(context_state->draw_state))
+                return true;
+
+        mct_draw_state_free(context_state->draw_state);
+        context_state->draw_state = NULL;
+
+        return false;
 }
 
-static void
-mct_window_swap(struct mct_window *window)
+struct mct_init_thread {
+        pthread_t thread;
+        struct mct_display *display;
+        const struct mct_config *config;
+        struct mct_context_state *context_state;
+        bool result;
+};
+
+static void *
+init_thread_func(void *data)
 {
-        mct_window_make_current(window);
-        glXSwapBuffers(window->display, window->glx_window);
+        struct mct_init_thread *init_thread = data;
+
+        mct_display_init_thread(init_thread->display);
+
+        init_thread->result =
+                init_draw_state(init_thread->config,
+                                init_thread->context_state,
+                                NULL, /* share_state */
+                                NULL /* memory */) &&
+                finish_draw_state(init_thread->context_state);
+
+        mct_display_release_current(init_thread->display);
+
+        return NULL;
 }
 
-static struct mct_window *
-mct_window_new(Display *display,
-               int width, int height,
-               bool flush_on_release)
+static bool
+init_draw_states_threaded(struct mct_display *display,
+                          const struct mct_config *config,
+                          struct mct_context_state *context_states)
 {
-        int context_attribs[] = {
-                GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
-                GLX_CONTEXT_MINOR_VERSION_ARB, 3,
-                GLX_CONTEXT_PROFILE_MASK_ARB,
-                GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-                GLX_CONTEXT_FLAGS_ARB,
-                GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
-                GLX_CONTEXT_RELEASE_BEHAVIOR_ARB,
-                GLX_CONTEXT_RELEASE_BEHAVIOR_NONE_ARB,
-                None
-        };
-        GLXFBConfig fb_config;
-        GLXContext ctx;
-        int scrnum = 0;
-        XSetWindowAttributes attr;
-        unsigned long mask;
-        Window root;
-        XVisualInfo *visinfo;
-        struct mct_window *window;
-        PFNGLXCREATECONTEXTATTRIBSARBPROC create_context_attribs;
-        bool has_flush_ext;
+        struct mct_init_thread *init_threads;
+        bool ret = true;
+        int i;
 
-        if (!check_glx_extension(display, "GLX_ARB_create_context")) {
-                fprintf(stderr,
-                        "GLX_ARB_create_context is not supported\n");
-                return NULL;
+        /* Without driver support for compiling in the background
+         * each context's program is compiled on its own thread
+         * instead. The contexts can't be current on this thread
+         * meanwhile. */
+        mct_display_release_current(display);
+
+        init_threads = malloc(sizeof *init_threads * config->n_contexts);
+
+        for (i = 0; i < config->n_contexts; i++) {
+                init_threads[i].display = display;
+                init_threads[i].config = config;
+                init_threads[i].context_state = context_states + i;
+
+                if (pthread_create(&init_threads[i].thread,
+                                   NULL, /* attr */
+                                   init_thread_func,
+                                   init_threads + i)) {
+                        fprintf(stderr, "Failed to create a thread\n");
+                        exit(EXIT_FAILURE);
+                }
+        }
+
+        for (i = 0; i < config->n_contexts; i++) {
+                pthread_join(init_threads[i].thread, NULL);
+                if (!init_threads[i].result)
+                        ret = false;
         }
 
-        has_flush_ext = check_glx_extension(display,
-                                            "GLX_ARB_context_flush_control");
+        free(init_threads);
 
-        if (flush_on_release) {
-                if (has_flush_ext) {
-                        context_attribs[sizeof context_attribs /
-                                        sizeof context_attribs[0] - 2] =
-                                GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB;
+        return ret;
+}
+
+static bool
+init_draw_states(const struct mct_config *config,
+                 struct mct_context_state *context_states,
+                 struct mct_memory_usage *memory)
+{
+        struct mct_draw_state *share_state = NULL;
+        int n_pending = 0;
+        bool pending[config->n_contexts];
+        bool ret = true;
+        int i, n_finished;
+
+        for (i = 0; i < config->n_contexts; i++) {
+                if (config->share && i > 0)
+                        share_state = context_states[0].draw_state;
+
+                if (!init_draw_state(config,
+                                     context_states + i,
+                                     share_state,
+                                     memory))
+                        return false;
+
+                /* In serial mode each program is finished straight
+                 * away. A shared program has to be finished before
+                 * the other contexts can use it. */
+                if (!config->parallel_compile || config->share) {
+                        pending[i] = false;
+                        if (!finish_draw_state(context_states + i))
+                                return false;
                 } else {
-                        context_attribs[sizeof context_attribs /
-                                        sizeof context_attribs[0] - 3] = None;
+                        pending[i] = true;
+                        n_pending++;
                 }
-        } else if (!has_flush_ext) {
-                fprintf(stderr,
-                        "Requested disabling flush on release but "
-                        "GLX_ARB_context_flush_control is not "
-                        "available\n");
-                return NULL;
         }
 
-        fb_config = choose_fb_config(display);
-
-        if (fb_config == NULL) {
-                fprintf(stderr,
-                        "No suitable GLXFBConfig found\n");
-                return NULL;
-        }
+        while (n_pending > 0) {
+                n_finished = 0;
 
-        visinfo = glXGetVisualFromFBConfig(display, fb_config);
+                for (i = 0; i < config->n_contexts; i++) {
+                        if (!pending[i])
+                                continue;
 
-        if (visinfo == NULL) {
-                fprintf(stderr,
-                         "FB config does not have an associated visual\n");
-                return NULL;
-        }
+                        mct_window_make_current(context_states[i].window);
 
-        create_context_attribs =
-                (void *) glXGetProcAddress((const GLubyte *)
-                                           "glXCreateContextAttribsARB");
-        ctx = create_context_attribs(display,
-                                     fb_config,
-                                     NULL, /* share_context */
-                                     True, /* direct */
-                                     context_attribs);
+                        if (!mct_draw_state_is_ready(context_states[i].
+                                                     draw_state))
+                                continue;
 
-        if (ctx == NULL) {
-                fprintf(stderr,
-                        "Error: glXCreateContextAttribs failed\n");
-                return NULL;
-        }
+                        pending[i] = false;
+                        n_pending--;
+                        n_finished++;
 
-        window = malloc(sizeof *window);
+                        if (!finish_draw_state(context_states + i))
+                                ret = false;
+                }
 
-        root = RootWindow(display, scrnum);
+                if (n_finished > 0 || n_pending == 0)
+                        continue;
 
-        /* window attributes */
-        attr.background_pixel = 0;
-        attr.border_pixel = 0;
-        attr.colormap =
-            XCreateColormap(display, root, visinfo->visual, AllocNone);
-        attr.event_mask =
-            StructureNotifyMask | ExposureMask | PointerMotionMask |
-            KeyPressMask;
-        mask = CWBorderPixel | CWColormap | CWEventMask;
+                /* Nothing is ready yet so block on the first one
+                 * rather than spinning */
+                for (i = 0; !pending[i]; i++);
 
-        window->win = XCreateWindow(display, root, 0, 0, width, height,
-                                    0, visinfo->depth, InputOutput,
-                                    visinfo->visual, mask, &attr);
+                mct_window_make_current(context_states[i].window);
 
-        window->glx_window = glXCreateWindow(display, fb_config,
-                                             window->win, NULL);
+                pending[i] = false;
+                n_pending--;
 
-        window->context = ctx;
-        window->display = display;
+                if (!finish_draw_state(context_states + i))
+                        ret = false;
+        }
 
-        return window;
+        return ret;
 }
 
 static void
-mct_window_free(struct mct_window *window)
+init_context_state(struct mct_context_state *context_state,
+                   int id)
 {
-        glXDestroyContext(window->display, window->context);
-        glXDestroyWindow(window->display, window->glx_window);
-        XDestroyWindow(window->display, window->win);
-        free(window);
+        context_state->id = id;
+        context_state->draw_state = NULL;
+        context_state->make_current_time = 0;
+        memset(&context_state->make_current_perf,
+               0,
+               sizeof context_state->make_current_perf);
 }
 
-static void
-make_grid(GLuint *buffer,
-          GLuint *array,
-          int width,
-          int height)
+/* memory is NULL unless it should be sampled around creating each
+ * window and draw state */
+static bool
+init_contexts(struct mct_display *display,
+              const struct mct_config *config,
+              struct mct_context_state *context_states,
+              struct mct_memory_usage *memory)
 {
-        struct mct_vertex *vertex;
-        float sh;
-        float blx, bly;
-        int x, y;
+        struct mct_window *share_window = NULL;
+        struct mct_memory_sample start, end;
+        bool ret;
+        int i;
 
-        /* Makes a grid of triangles where each line of quads is
-         * represented as a triangle strip. Each line is intended to
-         * drawn separately */
+        /* All of the windows are created up front so that the
+         * programs for every context can be compiled at the same
+         * time */
+        for (i = 0; i < config->n_contexts; i++) {
+                if (config->share && i > 0)
+                        share_window = context_states[0].window;
 
-        glGenBuffers(1, buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, *buffer);
-        glBufferData(GL_ARRAY_BUFFER,
-                     sizeof (struct mct_vertex) * (width * 2 + 2) * height,
-                     NULL,
-                     GL_STATIC_DRAW);
-        vertex = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+                if (memory)
+                        sample_memory(&start);
 
-        sh = 2.0f / height;
+                context_states[i].window =
+                        mct_window_new(display,
+                                       config->width, config->height,
+                                       config->flush_on_release,
+                                       config->target ==
+                                       MCT_TARGET_SURFACELESS,
+                                       share_window);
+
+                if (context_states[i].window == NULL) {
+                        destroy_contexts(context_states, i);
+                        return false;
+                }
 
-        for (y = 0; y < height; y++) {
-                for (x = 0; x <= width; x++) {
-                        blx = x * 2.0f / width - 1.0f;
-                        bly = y * 2.0f / height - 1.0f;
+                init_context_state(context_states + i, i);
 
-                        vertex[0].x = blx;
-                        vertex[0].y = bly + sh;
+                if (memory) {
+                        /* Binding the new context lets the next
+                         * window's samples include the video memory */
+                        mct_window_make_current(context_states[i].window);
+                        sample_memory(&end);
+                        mct_memory_usage_add(memory + MCT_MEMORY_WINDOW,
+                                             &start,
+                                             &end,
+                                             1 /* count */);
+                }
+        }
 
-                        vertex[1].x = blx;
-                        vertex[1].y = bly;
+        if (config->present_timing) {
+                for (i = 0; i < config->n_contexts; i++) {
+                        if (!mct_window_enable_present_timing(context_states[i].
+                                                              window))
+                                break;
+                }
 
-                        vertex += 2;
+                if (i < config->n_contexts) {
+                        fprintf(stderr,
+                                "note: presentation timing is not "
+                                "available\n");
                 }
         }
 
-        glUnmapBuffer(GL_ARRAY_BUFFER);
+        mct_window_make_current(context_states[0].window);
+
+        /* The memory samples need the draw states to be created one
+         * at a time */
+        if (config->parallel_compile &&
+            !config->share &&
+            config->n_contexts > 1 &&
+            memory == NULL &&
+            !shader_data_has_parallel_compile()) {
+                ret = init_draw_states_threaded(display,
+                                                config,
+                                                context_states);
+        } else {
+                ret = init_draw_states(config, context_states, memory);
+        }
 
-        glGenVertexArrays(1, array);
-        glBindVertexArray(*array);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, /* index */
-                              2, /* size */
-                              GL_FLOAT,
-                              GL_FALSE, /* normalized */
-                              sizeof (struct mct_vertex),
-                              (void *) offsetof(struct mct_vertex, x));
+        if (!ret) {
+                destroy_contexts(context_states, config->n_contexts);
+                return false;
+        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        return true;
 }
 
-static struct mct_draw_state *
-mct_draw_state_new(void)
+static void
+frame_stats_init(struct mct_frame_stats *stats)
 {
-        struct mct_draw_state *draw_state;
-        GLuint prog;
+        int i;
+
+        for (i = 0; i < MCT_N_PHASES; i++)
+                mct_histogram_init(stats->phases + i);
 
-        prog = shader_data_load_program(GL_VERTEX_SHADER,
-                                        "vertex-shader.glsl",
-                                        GL_FRAGMENT_SHADER,
-                                        "fragment-shader.glsl",
-                                        GL_NONE);
+        mct_histogram_init(&stats->make_current);
+        stats->redundant_make_current_time = 0;
 
-        if (prog == 0)
-                return NULL;
+        memset(stats->phase_perf, 0, sizeof stats->phase_perf);
+        memset(&stats->make_current_perf, 0, sizeof stats->make_current_perf);
+}
 
-        draw_state = malloc(sizeof *draw_state);
+static void
+frame_stats_merge(struct mct_frame_stats *stats,
+                  const struct mct_frame_stats *other)
+{
+        int i;
 
-        make_grid(&draw_state->grid_buffer,
-                  &draw_state->grid_array,
-                  GRID_WIDTH, GRID_HEIGHT);
+        for (i = 0; i < MCT_N_PHASES; i++) {
+                mct_histogram_merge(stats->phases + i, other->phases + i);
+                mct_perf_values_add(stats->phase_perf + i,
+                                    other->phase_perf + i);
+        }
 
-        draw_state->prog = prog;
+        mct_histogram_merge(&stats->make_current, &other->make_current);
+        stats->redundant_make_current_time +=
+                other->redundant_make_current_time;
+        mct_perf_values_add(&stats->make_current_perf,
+                            &other->make_current_perf);
+}
 
-        draw_state->band_pos_location =
-                glGetUniformLocation(prog, "band_pos");
+/* Records the start of a phase or the end of the frame */
+static void
+mark_phase(struct mct_frame_stats *stats,
+           uint64_t *times,
+           struct mct_perf_values *perf_values,
+           enum mct_phase phase)
+{
+        times[phase] = mct_get_time_ns();
 
-        return draw_state;
+        if (stats->perf)
+                mct_perf_read(stats->perf, perf_values + phase);
 }
 
 static void
-mct_draw_state_start(struct mct_draw_state *draw_state)
+add_phases(struct mct_frame_stats *stats,
+           const uint64_t *times,
+           const struct mct_perf_values *perf_values,
+           bool whole_frame)
 {
-        struct timeval tv;
+        int i;
+
+        for (i = MCT_PHASE_START; i <= MCT_PHASE_END; i++) {
+                mct_histogram_add(stats->phases + i,
+                                  times[i + 1] - times[i]);
+                if (stats->perf) {
+                        mct_perf_values_add_delta(stats->phase_perf + i,
+                                                  perf_values + i,
+                                                  perf_values + i + 1);
+                }
+        }
 
-        glBindVertexArray(draw_state->grid_array);
-        glUseProgram(draw_state->prog);
+        if (!whole_frame)
+                return;
 
-        gettimeofday(&tv, NULL);
+        mct_histogram_add(stats->phases + MCT_PHASE_FRAME,
+                          times[MCT_PHASE_FRAME] -
+                          times[MCT_PHASE_START]);
 
-        glUniform1f(draw_state->band_pos_location,
-                    tv.tv_usec / 1000000.0f);
+        if (stats->perf) {
+                mct_perf_values_add_delta(stats->phase_perf + MCT_PHASE_FRAME,
+                                          perf_values + MCT_PHASE_START,
+                                          perf_values + MCT_PHASE_FRAME);
+        }
 }
 
 static void
-mct_draw_state_draw_row(struct mct_draw_state *draw_state, int y)
+make_current(struct mct_frame_stats *stats,
+             struct mct_context_state *context_state)
 {
-        glDrawArrays(GL_TRIANGLE_STRIP,
-                     y * (GRID_WIDTH * 2 + 2),
-                     GRID_WIDTH * 2 + 2);
+        bool redundant = mct_window_is_current(context_state->window);
+        struct mct_perf_values perf_start, perf_end;
+        uint64_t start_time, elapsed;
+
+        if (stats->perf)
+                mct_perf_read(stats->perf, &perf_start);
+
+        start_time = mct_get_time_ns();
+
+        mct_window_make_current(context_state->window);
+
+        elapsed = mct_get_time_ns() - start_time;
+
+        mct_trace_add(MCT_TRACE_MAKE_CURRENT,
+                      start_time,
+                      start_time + elapsed,
+                      context_state->id,
+                      0);
+
+        if (stats->perf) {
+                mct_perf_read(stats->perf, &perf_end);
+                mct_perf_values_add_delta(&stats->make_current_perf,
+                                          &perf_start,
+                                          &perf_end);
+                mct_perf_values_add_delta(&context_state->make_current_perf,
+                                          &perf_start,
+                                          &perf_end);
+        }
+
+        mct_histogram_add(&stats->make_current, elapsed);
+        context_state->make_current_time += elapsed;
+
+        if (redundant)
+                stats->redundant_make_current_time += elapsed;
 }
 
 static void
-mct_draw_state_end(struct mct_draw_state *draw_state)
+sync_before_switch(const struct mct_config *config,
+                   GLsync *fence)
 {
-        glUseProgram(0);
-        glBindVertexArray(0);
+        switch ((enum mct_sync) config->sync) {
+        case MCT_SYNC_NONE:
+                break;
+        case MCT_SYNC_FLUSH:
+                glFlush();
+                break;
+        case MCT_SYNC_FINISH:
+                glFinish();
+                break;
+        case MCT_SYNC_FENCE_SERVER:
+        case MCT_SYNC_FENCE_CLIENT:
+                *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                /* Another context can only wait for the fence once
+                 * it has been flushed */
+                glFlush();
+                break;
+        }
 }
 
 static void
-mct_draw_state_free(struct mct_draw_state *draw_state)
+sync_after_switch(const struct mct_config *config,
+                  GLsync *fence)
 {
-        glDeleteVertexArrays(1, &draw_state->grid_array);
-        glDeleteBuffers(1, &draw_state->grid_buffer);
-        glDeleteProgram(draw_state->prog);
+        if (*fence == NULL)
+                return;
 
-        free(draw_state);
+        if (config->sync == MCT_SYNC_FENCE_SERVER)
+                glWaitSync(*fence, 0, GL_TIMEOUT_IGNORED);
+        else
+                glClientWaitSync(*fence, 0, UINT64_MAX);
+
+        glDeleteSync(*fence);
+        *fence = NULL;
 }
 
 static void
-destroy_contexts(struct mct_context_state *context_states,
-                 int n_contexts)
+draw_rows(struct mct_context_state *context_state,
+          int y,
+          int n_rows)
 {
-        int i;
+        uint64_t start_time = mct_trace_begin();
 
-        for (i = n_contexts - 1; i >= 0; i--) {
-                mct_window_make_current(context_states[i].window);
-                mct_draw_state_free(context_states[i].draw_state);
-                mct_window_free(context_states[i].window);
-        }
+        mct_draw_state_draw_rows(context_state->draw_state, y, n_rows);
+
+        mct_trace_end(MCT_TRACE_DRAW_ROWS, start_time, context_state->id, y);
 }
 
 static void
-set_swap_interval(struct mct_window *window)
+start_context(struct mct_context_state *context_state)
 {
-        PFNGLXSWAPINTERVALMESAPROC swap_interval_mesa;
-        PFNGLXSWAPINTERVALMESAPROC swap_interval_sgi;
-
-        if (check_glx_extension(window->display, "GLX_MESA_swap_control")) {
-                swap_interval_mesa =
-                        (void *) glXGetProcAddress((const GLubyte *)
-                                                   "glXSwapIntervalMESA");
-                if (swap_interval_mesa(0) == 0)
-                        return;
-        }
+        uint64_t start_time = mct_trace_begin();
 
-        /* Try with the SGI extension. Technically this shouldn't work
-         * because the spec disallows swap interval 0 */
-        if (check_glx_extension(window->display, "GLX_SGI_swap_control")) {
-                swap_interval_sgi =
-                        (void *) glXGetProcAddress((const GLubyte *)
-                                                   "glXSwapIntervalSGI");
-                if (swap_interval_sgi(0) == 0)
-                        return;
-        }
+        mct_draw_state_start(context_state->draw_state);
 
-        fprintf(stderr,
-                "note: failed to set swap interval to 0 with either "
-                "GLX_MESA_swap_control or GLX_SGI_swap_control\n");
+        mct_trace_end(MCT_TRACE_START, start_time, context_state->id, 0);
 }
 
-static bool
-init_contexts(Display *display,
-              struct mct_context_state *context_states,
-              bool flush_on_release)
+static void
+end_context(const struct mct_config *config,
+            struct mct_context_state *context_state)
 {
-        int i;
+        uint64_t start_time = mct_trace_begin();
 
-        for (i = 0; i < N_WINDOWS; i++) {
-                context_states[i].window =
-                        mct_window_new(display, 640, 640, flush_on_release);
+        mct_draw_state_end(context_state->draw_state);
 
-                if (context_states[i].window == NULL)
-                        goto error;
+        start_time = mct_trace_end(MCT_TRACE_END,
+                                   start_time,
+                                   context_state->id,
+                                   0);
 
-                mct_window_make_current(context_states[i].window);
+        /* Nothing is shown when drawing offscreen but the commands
+         * still need to be flushed as a swap would */
+        if (config->target != MCT_TARGET_WINDOW)
+                glFlush();
+        else
+                mct_window_swap(context_state->window);
 
-                set_swap_interval(context_states[i].window);
+        mct_trace_end(MCT_TRACE_SWAP, start_time, context_state->id, 0);
+}
 
-                context_states[i].draw_state = mct_draw_state_new();
+static void
+draw_context_window(const struct mct_config *config,
+                    struct mct_frame_stats *stats,
+                    struct mct_context_state *context_state,
+                    GLsync *fence,
+                    int y,
+                    int n_rows)
+{
+        make_current(stats, context_state);
+        sync_after_switch(config, fence);
+        draw_rows(context_state, y, n_rows);
+        sync_before_switch(config, fence);
+}
 
-                if (context_states[i].draw_state == NULL) {
-                        mct_window_free(context_states[i].window);
-                        goto error;
-                }
-        }
+static int
+get_batch_size(const struct mct_config *config,
+               int y)
+{
+        int n_rows = config->grid_height - y;
 
-        return true;
+        if (n_rows > config->rows_per_switch)
+                n_rows = config->rows_per_switch;
 
-error:
-        destroy_contexts(context_states, i);
-        return false;
+        return n_rows;
 }
 
-static void
-draw_context_window(struct mct_context_state *context_state,
-                    int y)
+static int
+get_switches_per_frame(const struct mct_config *config)
 {
-        mct_window_make_current(context_state->window);
-        mct_draw_state_draw_row(context_state->draw_state, y);
+        int n_batches = ((config->grid_height + config->rows_per_switch - 1) /
+                         config->rows_per_switch);
+
+        return n_batches * config->n_contexts;
 }
 
 static void
-draw_contexts(struct mct_context_state *context_states)
+draw_contexts(const struct mct_config *config,
+              struct mct_context_state *context_states,
+              struct mct_frame_stats *stats)
 {
-        int i, y;
-
-        for (i = 0; i < N_WINDOWS; i++) {
-                mct_window_make_current(context_states[i].window);
-                mct_draw_state_start(context_states[i].draw_state);
+        /* Start time of each phase. The last entry is the end of
+         * the frame */
+        uint64_t times[MCT_N_PHASES];
+        struct mct_perf_values perf_values[MCT_N_PHASES];
+        GLsync fence = NULL;
+        int i, y, n_rows;
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_START);
+
+        for (i = 0; i < config->n_contexts; i++) {
+                make_current(stats, context_states + i);
+                start_context(context_states + i);
         }
 
-        for (y = 0; y < GRID_HEIGHT; y++) {
-                for (i = 0; i < N_WINDOWS; i++) {
-                        draw_context_window(context_states + i, y);
+        mark_phase(stats, times, perf_values, MCT_PHASE_DRAW);
+
+        for (y = 0; y < config->grid_height; y += n_rows) {
+                n_rows = get_batch_size(config, y);
+
+                for (i = 0; i < config->n_contexts; i++) {
+                        draw_context_window(config,
+                                            stats,
+                                            context_states + i,
+                                            &fence,
+                                            y,
+                                            n_rows);
                 }
         }
 
-        for (i = 0; i < N_WINDOWS; i++) {
-                mct_window_make_current(context_states[i].window);
-                mct_draw_state_end(context_states[i].draw_state);
-                mct_window_swap(context_states[i].window);
+        /* The last fence is waited for by the context that made it */
+        sync_after_switch(config, &fence);
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_END);
+
+        for (i = 0; i < config->n_contexts; i++) {
+                make_current(stats, context_states + i);
+                end_context(config, context_states + i);
         }
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_FRAME);
+
+        mct_trace_add(MCT_TRACE_FRAME,
+                      times[MCT_PHASE_START],
+                      times[MCT_PHASE_FRAME],
+                      -1,
+                      0);
+
+        add_phases(stats, times, perf_values, true);
 }
 
 static void
-dump_release_behavior(void)
+draw_context(const struct mct_config *config,
+             struct mct_context_state *context_state,
+             struct mct_frame_stats *stats)
 {
-        GLint value;
+        uint64_t times[MCT_N_PHASES];
+        struct mct_perf_values perf_values[MCT_N_PHASES];
+        int y, n_rows;
 
-        if (epoxy_has_gl_extension("GL_KHR_context_flush_control")) {
-                glGetIntegerv(GL_CONTEXT_RELEASE_BEHAVIOR, &value);
-                printf("GL_CONTEXT_RELEASE_BEHAVIOR = 0x%04x ", value);
-                if (value == GL_NONE)
-                        printf("(GL_NONE)\n");
-                else if (value == GL_CONTEXT_RELEASE_BEHAVIOR_FLUSH)
-                        printf("(GL_CONTEXT_RELEASE_BEHAVIOR_FLUSH)\n");
-                else
-                        printf("(?)\n");
-        } else {
-                printf("GL_KHR_context_flush_control is unavailable\n");
+        mark_phase(stats, times, perf_values, MCT_PHASE_START);
+
+        make_current(stats, context_state);
+        start_context(context_state);
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_DRAW);
+
+        for (y = 0; y < config->grid_height; y += n_rows) {
+                n_rows = get_batch_size(config, y);
+                draw_rows(context_state, y, n_rows);
         }
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_END);
+
+        end_context(config, context_state);
+
+        mark_phase(stats, times, perf_values, MCT_PHASE_FRAME);
+
+        mct_trace_add(MCT_TRACE_FRAME,
+                      times[MCT_PHASE_START],
+                      times[MCT_PHASE_FRAME],
+                      context_state->id,
+                      0);
+
+        /* The main thread measures the whole frame */
+        add_phases(stats, times, perf_values, false);
 }
 
-static void
-usage(void)
+static void *
+worker_thread_func(void *data)
 {
-        fprintf(stderr, "usage: multi-context-test [flush/none]\n");
-        exit(EXIT_FAILURE);
+        struct mct_worker *worker = data;
+        struct mct_run *run = worker->run;
+        char name[32];
+
+        mct_display_init_thread(run->display);
+
+        snprintf(name, sizeof name, "context %i", worker->context_state->id);
+        mct_trace_set_thread(name);
+
+        if (run->config->perf_counters)
+                worker->stats.perf = mct_perf_new();
+
+        /* Bind the context to this thread before anything is
+         * measured and then tell the main thread that it is ready */
+        mct_window_make_current(worker->context_state->window);
+        mct_window_get_thread_make_current_stats(&worker->make_current_stats);
+        pthread_barrier_wait(&run->end_barrier);
+
+        while (true) {
+                pthread_barrier_wait(&run->start_barrier);
+
+                if (run->quit)
+                        break;
+
+                draw_context(run->config,
+                             worker->context_state,
+                             &worker->stats);
+
+                mct_window_get_thread_make_current_stats(&worker->
+                                                         make_current_stats);
+
+                pthread_barrier_wait(&run->end_barrier);
+        }
+
+        if (worker->stats.perf) {
+                mct_perf_free(worker->stats.perf);
+                worker->stats.perf = NULL;
+        }
+
+        mct_display_release_current(run->display);
+
+        return NULL;
 }
 
-int
-main(int argc, char **argv)
+static bool
+start_workers(struct mct_run *run)
 {
-        struct mct_context_state context_states[N_WINDOWS];
-        Display *display;
-        int frame_count = 0;
-        time_t last_time = 0, now;
-        bool flush_on_release = true;
+        struct mct_worker *worker;
+        int n_contexts = run->config->n_contexts;
         int i;
 
-        if (argc == 2) {
-                if (!strcmp(argv[1], "flush"))
-                        flush_on_release = true;
-                else if (!strcmp(argv[1], "none"))
-                        flush_on_release = false;
-                else
-                        usage();
-        } else if (argc != 1) {
-                usage();
+        /* The contexts can't be bound to the worker threads while
+         * they are still current on this one */
+        mct_display_release_current(run->display);
+
+        run->workers = malloc(sizeof *run->workers * n_contexts);
+        run->quit = false;
+        pthread_barrier_init(&run->start_barrier, NULL, n_contexts + 1);
+        pthread_barrier_init(&run->end_barrier, NULL, n_contexts + 1);
+
+        for (i = 0; i < n_contexts; i++) {
+                worker = run->workers + i;
+                worker->run = run;
+                worker->context_state = run->context_states + i;
+                frame_stats_init(&worker->stats);
+                worker->stats.perf = NULL;
+
+                if (pthread_create(&worker->thread,
+                                   NULL,
+                                   worker_thread_func,
+                                   worker)) {
+                        fprintf(stderr, "Failed to create a thread\n");
+                        exit(EXIT_FAILURE);
+                }
         }
 
-        display = XOpenDisplay(NULL);
+        pthread_barrier_wait(&run->end_barrier);
 
-        if (display == NULL) {
-                fprintf(stderr, "XOpenDisplay failed\n");
-                return EXIT_FAILURE;
-        }
+        return true;
+}
 
-        if (init_contexts(display, context_states, flush_on_release)) {
-                for (i = 0; i < N_WINDOWS; i++) {
-                        XMapWindow(display, context_states[i].window->win);
-                        mct_window_make_current(context_states[i].window);
-                        dump_release_behavior();
-                }
+/* Sums the make-current counters of this thread and the workers. The
+ * workers must be waiting for the next frame. */
+static void
+get_make_current_stats(struct mct_run *run,
+                       struct mct_make_current_stats *stats)
+{
+        const struct mct_make_current_stats *worker_stats;
+        int i;
 
-                while (true) {
-                        draw_contexts(context_states);
+        mct_window_get_thread_make_current_stats(stats);
 
-                        frame_count++;
+        if (run->workers == NULL)
+                return;
 
-                        time(&now);
-                        if (now != last_time) {
-                                printf("FPS = %i\n", frame_count);
-                                last_time = now;
-                                frame_count = 0;
-                        }
-                }
-                destroy_contexts(context_states, N_WINDOWS);
+        for (i = 0; i < run->config->n_contexts; i++) {
+                worker_stats = &run->workers[i].make_current_stats;
+                stats->calls += worker_stats->calls;
+                stats->redundant += worker_stats->redundant;
+                stats->elided += worker_stats->elided;
+        }
+}
+
+/* Moves the workers' statistics into the run's. The workers must be
+ * waiting for the next frame. */
+static void
+collect_worker_stats(struct mct_run *run)
+{
+        int i;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                /* The workers don't measure the whole frame so this
+                 * doesn't disturb the main thread's frame times */
+                frame_stats_merge(run->stats, &run->workers[i].stats);
+                frame_stats_init(&run->workers[i].stats);
         }
+}
 
-        XCloseDisplay(display);
+/* Joins the workers, which leaves none of the contexts current */
+static void
+stop_workers(struct mct_run *run)
+{
+        int i;
+
+        run->quit = true;
+        pthread_barrier_wait(&run->start_barrier);
+
+        for (i = 0; i < run->config->n_contexts; i++)
+                pthread_join(run->workers[i].thread, NULL);
+
+        pthread_barrier_destroy(&run->start_barrier);
+        pthread_barrier_destroy(&run->end_barrier);
+        free(run->workers);
+        run->workers = NULL;
+}
+
+static void
+readback_stats_add(struct mct_readback_stats *total,
+                   const struct mct_readback_stats *stats)
+{
+        total->checked += stats->checked;
+        total->corrupt += stats->corrupt;
+        total->wait_time += stats->wait_time;
+        total->hash_time += stats->hash_time;
+}
+
+/* Gives the tenant a context from the pool and builds its draw state
+ * in it if it doesn't have one yet */
+static bool
+acquire_pool_context(struct mct_run *run,
+                     struct mct_context_state *context_state)
+{
+        struct mct_memory_usage *memory =
+                run->config->memory ? run->memory : NULL;
+        struct mct_context_state *evicted_state;
+        struct mct_memory_sample start, end;
+        struct mct_draw_state *draw_state;
+        struct mct_window *window;
+        uint64_t start_time;
+        int evicted;
+
+        if (memory && context_state->draw_state == NULL)
+                sample_memory(&start);
+
+        window = mct_pool_acquire(run->pool, context_state->id, &evicted);
+        if (window == NULL)
+                return false;
+
+        if (context_state->draw_state)
+                return true;
+
+        /* A tenant without a draw state that didn't take another's
+         * context got a new one */
+        if (memory && evicted < 0) {
+                mct_window_make_current(window);
+                sample_memory(&end);
+                mct_memory_usage_add(memory + MCT_MEMORY_WINDOW,
+                                     &start,
+                                     &end,
+                                     1 /* count */);
+        }
+
+        start_time = mct_get_time_ns();
+
+        if (evicted >= 0) {
+                evicted_state = run->context_states + evicted;
+                draw_state = evicted_state->draw_state;
+
+                mct_window_make_current(window);
+
+                if (run->config->verify) {
+                        readback_stats_add(&run->evicted_readback_stats,
+                                           mct_draw_state_get_readback_stats(
+                                                   draw_state));
+                }
+
+                mct_draw_state_free(draw_state);
+                evicted_state->draw_state = NULL;
+                evicted_state->window = NULL;
+        }
+
+        context_state->window = window;
+
+        if (!init_draw_state(run->config, context_state, NULL, memory) ||
+            !finish_draw_state(context_state))
+                return false;
+
+        mct_histogram_add(run->state_init_time,
+                          mct_get_time_ns() - start_time);
+
+        return true;
+}
+
+static void
+draw_pool(struct mct_run *run)
+{
+        struct mct_context_state *context_state;
+        uint64_t start_time, end_time;
+        int i;
+
+        start_time = mct_get_time_ns();
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                context_state = run->context_states + i;
+
+                if (!acquire_pool_context(run, context_state)) {
+                        fprintf(stderr,
+                                "Failed to get a context from the pool\n");
+                        exit(EXIT_FAILURE);
+                }
+
+                draw_context(run->config, context_state, run->stats);
+        }
+
+        end_time = mct_get_time_ns();
+
+        /* This includes creating and recycling the contexts */
+        mct_histogram_add(run->stats->phases + MCT_PHASE_FRAME,
+                          end_time - start_time);
+        mct_trace_add(MCT_TRACE_FRAME, start_time, end_time, -1, 0);
+}
+
+static void
+run_frame(struct mct_run *run)
+{
+        uint64_t start_time, end_time;
+
+        if (run->config->mode == MCT_MODE_SINGLE) {
+                draw_contexts(run->config, run->context_states, run->stats);
+                return;
+        }
+
+        if (run->config->mode == MCT_MODE_POOL) {
+                draw_pool(run);
+                return;
+        }
+
+        start_time = mct_get_time_ns();
+
+        pthread_barrier_wait(&run->start_barrier);
+        pthread_barrier_wait(&run->end_barrier);
+
+        end_time = mct_get_time_ns();
+
+        mct_histogram_add(run->stats->phases + MCT_PHASE_FRAME,
+                          end_time - start_time);
+        mct_trace_add(MCT_TRACE_FRAME, start_time, end_time, -1, 0);
+}
+
+static void
+dump_release_behavior(FILE *out)
+{
+        GLint value;
+
+        if (epoxy_has_gl_extension("GL_KHR_context_flush_control")) {
+                glGetIntegerv(GL_CONTEXT_RELEASE_BEHAVIOR, &value);
+                fprintf(out, "GL_CONTEXT_RELEASE_BEHAVIOR = 0x%04x ", value);
+                if (value == GL_NONE)
+                        fprintf(out, "(GL_NONE)\n");
+                else if (value == GL_CONTEXT_RELEASE_BEHAVIOR_FLUSH)
+                        fprintf(out, "(GL_CONTEXT_RELEASE_BEHAVIOR_FLUSH)\n");
+                else
+                        fprintf(out, "(?)\n");
+        } else {
+                fprintf(out, "GL_KHR_context_flush_control is unavailable\n");
+        }
+}
+
+static struct mct_axis *
+find_axis(const char *name)
+{
+        int i;
+
+        for (i = 0; i < N_AXES; i++) {
+                if (!strcmp(axes[i].name, name))
+                        return axes + i;
+        }
+
+        return NULL;
+}
+
+static int *
+get_axis_member(struct mct_config *config,
+                const struct mct_axis *axis)
+{
+        return (int *) ((char *) config + axis->offset);
+}
+
+static const char *
+get_axis_value_name(const struct mct_axis *axis,
+                    int value)
+{
+        const struct mct_axis_name *name;
+
+        for (name = axis->names; name->name; name++) {
+                if (name->value == value)
+                        return name->name;
+        }
+
+        return "?";
+}
+
+static void
+add_axes_to_report(struct mct_report *report,
+                   struct mct_config *config)
+{
+        const struct mct_axis *axis;
+        int value;
+        int i;
+
+        for (i = 0; i < N_AXES; i++) {
+                axis = axes + i;
+                value = *get_axis_member(config, axis);
+
+                if (axis->names == NULL) {
+                        mct_report_add_int(report, axis->name, value);
+                        continue;
+                }
+
+                mct_report_add_string(report,
+                                      axis->name,
+                                      get_axis_value_name(axis, value));
+        }
+}
+
+static void
+add_perf_values_to_report(struct mct_report *report,
+                          const struct mct_perf *perf,
+                          const char *prefix,
+                          const char *suffix,
+                          const struct mct_perf_values *values,
+                          uint64_t count)
+{
+        char name[128];
+        int i;
+
+        for (i = 0; i < MCT_PERF_N_COUNTERS; i++) {
+                if (!mct_perf_has_counter(perf, i))
+                        continue;
+
+                /* The counters only follow the thread that drew, not
+                 * the driver's threads */
+                snprintf(name, sizeof name,
+                         "%s_thread_%s_%s",
+                         prefix,
+                         mct_perf_counter_names[i],
+                         suffix);
+                mct_report_add_double(report,
+                                      name,
+                                      count ?
+                                      values->values[i] / (double) count :
+                                      0.0);
+        }
+}
+
+static void
+add_frame_stats_to_report(struct mct_report *report,
+                          const struct mct_frame_stats *stats)
+{
+        const struct mct_histogram *frame_times =
+                stats->phases + MCT_PHASE_FRAME;
+        int i;
+
+        for (i = 0; i < MCT_N_PHASES; i++) {
+                mct_histogram_add_to_report(stats->phases + i,
+                                            report,
+                                            phase_names[i],
+                                            "ms",
+                                            1e6);
+        }
+
+        mct_histogram_add_to_report(&stats->make_current,
+                                    report,
+                                    "make_current",
+                                    "us",
+                                    1e3);
+        mct_report_add_double(report,
+                              "make_current_ms_per_frame",
+                              frame_times->count ?
+                              stats->make_current.sum / 1e6 /
+                              frame_times->count :
+                              0.0);
+        mct_report_add_double(report,
+                              "make_current_fraction",
+                              frame_times->sum ?
+                              stats->make_current.sum /
+                              (double) frame_times->sum :
+                              0.0);
+        mct_report_add_double(report,
+                              "redundant_make_current_ms_per_frame",
+                              frame_times->count ?
+                              stats->redundant_make_current_time / 1e6 /
+                              frame_times->count :
+                              0.0);
+
+        if (stats->perf == NULL)
+                return;
+
+        for (i = 0; i < MCT_N_PHASES; i++) {
+                add_perf_values_to_report(report,
+                                          stats->perf,
+                                          phase_names[i],
+                                          "per_frame",
+                                          stats->phase_perf + i,
+                                          frame_times->count);
+        }
+
+        add_perf_values_to_report(report,
+                                  stats->perf,
+                                  "make_current",
+                                  "per_call",
+                                  &stats->make_current_perf,
+                                  stats->make_current.count);
+}
+
+static void
+add_run_header_to_report(struct mct_report *report,
+                         enum mct_platform platform,
+                         struct mct_config *config)
+{
+        mct_report_add_string(report,
+                              "platform",
+                              mct_platform_to_string(platform));
+        add_axes_to_report(report, config);
+}
+
+static void
+add_gpu_timings_to_report(struct mct_report *report,
+                          const struct mct_gpu_timings *timings)
+{
+        double cpu_mean, gpu_mean;
+
+        mct_report_add_int(report, "timed_frames",
+                           timings->gpu.count);
+        mct_report_add_int(report, "dropped_frames",
+                           timings->dropped);
+        mct_report_add_int(report, "discarded_frames",
+                           timings->discarded);
+        mct_histogram_add_to_report(&timings->cpu,
+                                    report,
+                                    "cpu_submit",
+                                    "ms",
+                                    1e6);
+        mct_histogram_add_to_report(&timings->gpu,
+                                    report,
+                                    "gpu",
+                                    "ms",
+                                    1e6);
+        mct_histogram_add_to_report(&timings->latency,
+                                    report,
+                                    "gpu_latency",
+                                    "ms",
+                                    1e6);
+
+        if (timings->gpu.count > 0) {
+                cpu_mean = timings->cpu.sum / 1e6 /
+                        timings->cpu.count;
+                gpu_mean = timings->gpu.sum / 1e6 /
+                        timings->gpu.count;
+        } else {
+                cpu_mean = gpu_mean = 0.0;
+        }
+
+        mct_report_add_double(report, "cpu_submit_mean_ms", cpu_mean);
+        mct_report_add_double(report, "gpu_mean_ms", gpu_mean);
+        mct_report_add_double(report,
+                              "gpu_cpu_gap_ms",
+                              gpu_mean - cpu_mean);
+}
+
+static void
+add_present_stats_to_report(struct mct_report *report,
+                            const struct mct_present_stats *stats)
+{
+        mct_report_add_int(report, "presented_frames", stats->latency.count);
+        mct_histogram_add_to_report(&stats->latency,
+                                    report,
+                                    "present_latency",
+                                    "ms",
+                                    1e6);
+        mct_report_add_int(report, "missed_vblanks", stats->missed_vblanks);
+        mct_report_add_int(report, "present_dropped", stats->dropped);
+}
+
+static void
+report_contexts(struct mct_report *report,
+                enum mct_platform platform,
+                struct mct_config *config,
+                struct mct_context_state *context_states,
+                const struct mct_perf *perf,
+                long long frame_count)
+{
+        const struct mct_gpu_timings *timings;
+        const struct mct_present_stats *present_stats;
+        int i;
+
+        for (i = 0; i < config->n_contexts; i++) {
+                /* A tenant in pool mode might not have a context */
+                if (context_states[i].draw_state == NULL)
+                        continue;
+
+                mct_window_make_current(context_states[i].window);
+                timings = mct_draw_state_get_gpu_timings(context_states[i].
+                                                         draw_state);
+                present_stats =
+                        mct_window_get_present_stats(context_states[i].window);
+
+                if (timings == NULL && present_stats == NULL && perf == NULL)
+                        continue;
+
+                mct_report_begin_record(report, "context");
+                add_run_header_to_report(report, platform, config);
+                mct_report_add_int(report, "context", i);
+                mct_report_add_double(report,
+                                      "make_current_ms_per_frame",
+                                      context_states[i].make_current_time /
+                                      1e6 / frame_count);
+                if (perf) {
+                        add_perf_values_to_report(report,
+                                                  perf,
+                                                  "make_current",
+                                                  "per_frame",
+                                                  &context_states[i].
+                                                  make_current_perf,
+                                                  frame_count);
+                }
+
+                if (timings)
+                        add_gpu_timings_to_report(report, timings);
+                if (present_stats)
+                        add_present_stats_to_report(report, present_stats);
+
+                mct_report_end_record(report);
+        }
+}
+
+static void
+add_init_stats_to_report(struct mct_report *report,
+                         struct mct_run *run)
+{
+        size_t grid_buffer_size = 0;
+        int i;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                if (run->context_states[i].draw_state == NULL)
+                        continue;
+                grid_buffer_size +=
+                        mct_draw_state_get_grid_buffer_size(run->
+                                                            context_states[i].
+                                                            draw_state);
+        }
+
+        mct_report_add_double(report, "init_ms", run->init_time / 1e6);
+        mct_report_add_int(report, "init_rss_kb", run->init_rss);
+        mct_report_add_int(report, "grid_buffer_bytes", grid_buffer_size);
+        mct_report_add_int(report,
+                           "program_cache_hits",
+                           run->cache_stats.hits);
+        mct_report_add_int(report,
+                           "program_cache_misses",
+                           run->cache_stats.misses);
+        mct_report_add_int(report,
+                           "program_cache_rejected",
+                           run->cache_stats.rejected);
+}
+
+static size_t
+get_frame_vertex_bytes(struct mct_run *run)
+{
+        struct mct_draw_state *draw_state;
+        size_t total = 0;
+        int i, n_draw_states = 0;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                draw_state = run->context_states[i].draw_state;
+                if (draw_state == NULL)
+                        continue;
+                total += mct_draw_state_get_frame_vertex_bytes(draw_state);
+                n_draw_states++;
+        }
+
+        /* The tenants that don't have a context in pool mode draw
+         * the same as the others */
+        if (n_draw_states == 0)
+                return 0;
+
+        return total * run->config->n_contexts / n_draw_states;
+}
+
+/* Returns false if any of the frames didn't match the reference or if
+ * none were checked at all */
+static bool
+add_readback_stats_to_report(struct mct_report *report,
+                             const struct mct_readback_stats *stats,
+                             long long frame_count)
+{
+        mct_report_add_int(report, "checked_frames", stats->checked);
+        mct_report_add_int(report, "corrupt_frames", stats->corrupt);
+        mct_report_add_double(report,
+                              "readback_wait_ms_per_frame",
+                              frame_count > 0 ?
+                              stats->wait_time / 1e6 / frame_count : 0.0);
+        mct_report_add_double(report,
+                              "readback_hash_ms_per_frame",
+                              frame_count > 0 ?
+                              stats->hash_time / 1e6 / frame_count : 0.0);
+
+        if (stats->checked == 0) {
+                fprintf(stderr, "error: none of the frames were checked\n");
+                return false;
+        }
+
+        if (stats->corrupt > 0) {
+                fprintf(stderr,
+                        "error: %llu of %llu frames didn't match the "
+                        "reference\n",
+                        (unsigned long long) stats->corrupt,
+                        (unsigned long long) stats->checked);
+                return false;
+        }
+
+        return true;
+}
+
+static void
+add_stream_stats_to_report(struct mct_report *report,
+                           struct mct_run *run,
+                           long long frame_count,
+                           double elapsed)
+{
+        const struct mct_stream_stats *stream_stats;
+        struct mct_stream_stats total = { 0 };
+        int i;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                if (run->context_states[i].draw_state == NULL)
+                        continue;
+
+                stream_stats =
+                        mct_draw_state_get_stream_stats(run->
+                                                        context_states[i].
+                                                        draw_state);
+                if (stream_stats == NULL)
+                        continue;
+
+                total.bytes += stream_stats->bytes;
+                total.write_time += stream_stats->write_time;
+                total.wait_time += stream_stats->wait_time;
+                total.n_stalls += stream_stats->n_stalls;
+        }
+
+        mct_report_add_double(report,
+                              "upload_mb_per_second",
+                              total.bytes / elapsed / 1e6);
+        mct_report_add_double(report,
+                              "upload_write_mb_per_second",
+                              total.write_time > 0 ?
+                              total.bytes * 1e3 / total.write_time : 0.0);
+        mct_report_add_double(report,
+                              "upload_wait_ms_per_frame",
+                              frame_count > 0 ?
+                              total.wait_time / 1e6 / frame_count : 0.0);
+        mct_report_add_int(report, "upload_stalls", total.n_stalls);
+}
+
+static void
+add_make_current_stats_to_report(struct mct_report *report,
+                                 const struct mct_make_current_stats *stats,
+                                 long long frame_count)
+{
+        double frames = frame_count > 0 ? frame_count : 1;
+
+        mct_report_add_double(report,
+                              "make_current_calls_per_frame",
+                              stats->calls / frames);
+        mct_report_add_double(report,
+                              "make_current_redundant_per_frame",
+                              stats->redundant / frames);
+        mct_report_add_double(report,
+                              "make_current_elided_per_frame",
+                              stats->elided / frames);
+}
+
+static void
+add_memory_usage_to_report(struct mct_report *report,
+                           const char *prefix,
+                           const struct mct_memory_usage *usage)
+{
+        char key[64];
+
+        if (usage->count <= 0)
+                return;
+
+        if (usage->rss != MCT_MEMORY_UNKNOWN) {
+                snprintf(key, sizeof key, "%s_rss_kb", prefix);
+                mct_report_add_double(report,
+                                      key,
+                                      usage->rss / (double) usage->count);
+        }
+        if (usage->pss != MCT_MEMORY_UNKNOWN) {
+                snprintf(key, sizeof key, "%s_pss_kb", prefix);
+                mct_report_add_double(report,
+                                      key,
+                                      usage->pss / (double) usage->count);
+        }
+        if (usage->gpu_count > 0) {
+                snprintf(key, sizeof key, "%s_gpu_kb", prefix);
+                mct_report_add_double(report,
+                                      key,
+                                      usage->gpu / (double) usage->gpu_count);
+        }
+}
+
+static double
+get_gpu_per_object(const struct mct_memory_usage *usage)
+{
+        if (usage->gpu_count <= 0)
+                return 0.0;
+
+        return usage->gpu / (double) usage->gpu_count;
+}
+
+/* Reports the growth at each point where the memory was sampled as
+ * the average for each context and an estimate of how many more
+ * contexts would fit in the free video memory */
+static void
+add_memory_stats_to_report(struct mct_report *report,
+                           struct mct_run *run)
+{
+        struct mct_memory_usage *memory = run->memory;
+        struct mct_memory_sample end;
+        struct mct_window *window;
+        int i, n_contexts = 0;
+        double gpu_per_context;
+        long video_memory;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                if (run->context_states[i].draw_state == NULL)
+                        continue;
+                if (n_contexts++ == 0)
+                        mct_window_make_current(run->context_states[i].window);
+        }
+
+        sample_memory(&end);
+
+        /* In pool mode the contexts are created while running so the
+         * growth isn't steady */
+        mct_memory_usage_init(memory + MCT_MEMORY_STEADY);
+        if (run->pool == NULL) {
+                mct_memory_usage_add(memory + MCT_MEMORY_STEADY,
+                                     &run->init_memory,
+                                     &end,
+                                     n_contexts);
+        }
+
+        for (i = 0; i < MCT_N_MEMORY_STAGES; i++) {
+                add_memory_usage_to_report(report,
+                                           memory_stage_names[i],
+                                           memory + i);
+        }
+
+        mct_report_add_int(report, "rss_kb", end.rss);
+        if (end.pss >= 0 && run->start_memory.pss >= 0 && n_contexts > 0) {
+                mct_report_add_int(report, "pss_kb", end.pss);
+                mct_report_add_double(report,
+                                      "pss_kb_per_context",
+                                      (end.pss - run->start_memory.pss) /
+                                      (double) n_contexts);
+        }
+
+        window = mct_window_get_current();
+        if (window == NULL)
+                return;
+
+        if (!mct_window_get_video_memory(window, &video_memory))
+                video_memory = mct_memory_get_gpu_total();
+        if (video_memory >= 0)
+                mct_report_add_int(report, "video_memory_kb", video_memory);
+
+        if (end.gpu_free < 0)
+                return;
+
+        mct_report_add_int(report, "gpu_free_kb", end.gpu_free);
+
+        gpu_per_context = (get_gpu_per_object(memory + MCT_MEMORY_WINDOW) +
+                           get_gpu_per_object(memory +
+                                              MCT_MEMORY_DRAW_STATE) +
+                           get_gpu_per_object(memory + MCT_MEMORY_STEADY));
+
+        if (gpu_per_context > 0.0) {
+                mct_report_add_double(report,
+                                      "gpu_kb_per_context",
+                                      gpu_per_context);
+                mct_report_add_int(report,
+                                   "more_contexts_that_fit",
+                                   end.gpu_free / gpu_per_context);
+        }
+}
+
+static void
+add_pool_stats_to_report(struct mct_report *report,
+                         struct mct_run *run,
+                         long long frame_count)
+{
+        struct mct_pool_stats *stats = malloc(sizeof *stats);
+
+        mct_pool_get_stats(run->pool, stats);
+
+        mct_report_add_int(report, "pool_contexts", stats->n_contexts);
+        mct_report_add_int(report, "contexts_created", stats->created);
+        mct_report_add_int(report, "contexts_recycled", stats->recycled);
+        mct_report_add_double(report,
+                              "recycles_per_frame",
+                              frame_count > 0 ?
+                              stats->recycled / (double) frame_count :
+                              0.0);
+        mct_histogram_add_to_report(&stats->create_time,
+                                    report,
+                                    "context_create",
+                                    "ms",
+                                    1e6);
+        mct_histogram_add_to_report(run->state_init_time,
+                                    report,
+                                    "state_init",
+                                    "ms",
+                                    1e6);
+        mct_report_add_double(report,
+                              "context_create_rss_kb",
+                              stats->created > 0 ?
+                              stats->create_rss / (double) stats->created :
+                              0.0);
+        mct_report_add_double(report,
+                              "rss_kb_per_context",
+                              stats->n_contexts > 0 ?
+                              stats->total_rss /
+                              (double) stats->n_contexts :
+                              0.0);
+
+        free(stats);
+}
+
+/* Runs frames until either limit is reached or the run is interrupted
+ * and returns the number of frames. A limit of zero means no limit.
+ * The actual time taken is returned in elapsed. */
+static long long
+run_block(struct mct_run *run,
+          double duration,
+          long long max_frames,
+          double *elapsed,
+          struct mct_make_current_stats *make_current_stats)
+{
+        struct mct_config *config = run->config;
+        struct mct_make_current_stats start_stats, end_stats;
+        uint64_t start_time, end_time;
+        long long frame_count = 0;
+
+        mct_display_set_make_current_cache(run->display,
+                                           config->make_current_cache);
+
+        get_make_current_stats(run, &start_stats);
+
+        start_time = mct_get_time_ns();
+        end_time = start_time + duration * 1e9;
+
+        do {
+                run_frame(run);
+                frame_count++;
+        } while (!interrupted &&
+                 (max_frames <= 0 || frame_count < max_frames) &&
+                 (duration <= 0.0 || mct_get_time_ns() < end_time));
+
+        *elapsed = (mct_get_time_ns() - start_time) / 1e9;
+
+        get_make_current_stats(run, &end_stats);
+
+        if (run->workers)
+                collect_worker_stats(run);
+
+        if (make_current_stats) {
+                make_current_stats->calls = end_stats.calls - start_stats.calls;
+                make_current_stats->redundant =
+                        end_stats.redundant - start_stats.redundant;
+                make_current_stats->elided =
+                        end_stats.elided - start_stats.elided;
+        }
+
+        return frame_count;
+}
+
+static FILE *
+get_info_out(struct mct_report *report)
+{
+        /* Keep stdout clean for the machine-readable formats */
+        if (mct_report_get_format(report) == MCT_REPORT_FORMAT_TEXT)
+                return stdout;
+        else
+                return stderr;
+}
+
+/* Runs until SIGINT or SIGTERM with a progress line every second.
+ * The statistics of the whole run are left in run->stats. */
+static long long
+run_until_interrupted(struct mct_run *run,
+                      FILE *out,
+                      double *elapsed,
+                      struct mct_make_current_stats *make_current_stats)
+{
+        struct mct_frame_stats *stats = run->stats;
+        const struct mct_histogram *frame_times =
+                stats->phases + MCT_PHASE_FRAME;
+        struct mct_make_current_stats block_make_current_stats;
+        struct mct_frame_stats *total;
+        long long frame_count = 0, block_frame_count;
+        double block_elapsed;
+
+        total = malloc(sizeof *total);
+        frame_stats_init(total);
+
+        memset(make_current_stats, 0, sizeof *make_current_stats);
+        *elapsed = 0.0;
+
+        while (!interrupted) {
+                block_frame_count = run_block(run,
+                                              1.0, /* duration */
+                                              0, /* max_frames */
+                                              &block_elapsed,
+                                              &block_make_current_stats);
+
+                fprintf(out,
+                        "FPS = %i (frame p50 = %.2f ms, "
+                        "p99 = %.2f ms, max = %.2f ms, "
+                        "make current p99 = %.1f us)\n",
+                        (int) (block_frame_count / block_elapsed + 0.5),
+                        mct_histogram_percentile(frame_times, 50.0) / 1e6,
+                        mct_histogram_percentile(frame_times, 99.0) / 1e6,
+                        frame_times->max / 1e6,
+                        mct_histogram_percentile(&stats->make_current,
+                                                 99.0) / 1e3);
+                fflush(out);
+
+                frame_count += block_frame_count;
+                *elapsed += block_elapsed;
+                make_current_stats->calls += block_make_current_stats.calls;
+                make_current_stats->redundant +=
+                        block_make_current_stats.redundant;
+                make_current_stats->elided += block_make_current_stats.elided;
+
+                frame_stats_merge(total, stats);
+                frame_stats_init(stats);
+        }
+
+        frame_stats_merge(stats, total);
+        free(total);
+
+        return frame_count;
+}
+
+/* Makes the fields that identify the run in the baseline. Only the
+ * axes given on the command line are used so that adding an axis
+ * later doesn't stop an older baseline from matching. */
+static void
+get_baseline_key(enum mct_platform platform,
+                 struct mct_config *config,
+                 char *buf,
+                 size_t size)
+{
+        const struct mct_axis *axis;
+        size_t length;
+        int value;
+        int i;
+
+        length = snprintf(buf, size,
+                          "platform=%s",
+                          mct_platform_to_string(platform));
+
+        for (i = 0; i < N_AXES && length < size; i++) {
+                axis = axes + i;
+                if (!axis->given)
+                        continue;
+
+                value = *get_axis_member(config, axis);
+
+                if (axis->names) {
+                        length += snprintf(buf + length, size - length,
+                                           " %s=%s",
+                                           axis->name,
+                                           get_axis_value_name(axis, value));
+                } else {
+                        length += snprintf(buf + length, size - length,
+                                           " %s=%i",
+                                           axis->name,
+                                           value);
+                }
+        }
+}
+
+static void
+add_baseline_to_report(struct mct_session *session,
+                       struct mct_config *config,
+                       double fps)
+{
+        char key[1024];
+        double baseline_fps, change;
+
+        get_baseline_key(session->platform, config, key, sizeof key);
+
+        if (!mct_baseline_lookup(session->baseline,
+                                 key,
+                                 "fps",
+                                 &baseline_fps) ||
+            baseline_fps <= 0.0) {
+                fprintf(stderr, "error: no baseline for %s\n", key);
+                session->n_missing_baselines++;
+                return;
+        }
+
+        change = (fps / baseline_fps - 1.0) * 100.0;
+
+        mct_report_add_double(session->report, "baseline_fps", baseline_fps);
+        mct_report_add_double(session->report, "fps_change_percent", change);
+
+        if (change < -session->threshold) {
+                fprintf(stderr,
+                        "regression: %s: %.1f fps is %.1f%% below the "
+                        "baseline of %.1f fps\n",
+                        key,
+                        fps,
+                        -change,
+                        baseline_fps);
+                session->n_regressions++;
+        }
+}
+
+/* Returns false if any of the frames were drawn wrongly */
+static bool
+run_and_report(struct mct_session *session,
+               struct mct_run *run)
+{
+        struct mct_report *report = session->report;
+        enum mct_platform platform = session->platform;
+        struct mct_config *config = run->config;
+        struct mct_make_current_stats make_current_stats;
+        struct mct_readback_stats readback_stats = { 0 };
+        struct mct_draw_state *draw_state;
+        bool verified = true;
+        double elapsed;
+        long long frame_count;
+        int i;
+
+        if (session->duration > 0.0 || session->max_frames > 0) {
+                frame_count = run_block(run,
+                                        session->duration,
+                                        session->max_frames,
+                                        &elapsed,
+                                        &make_current_stats);
+        } else {
+                frame_count = run_until_interrupted(run,
+                                                    get_info_out(report),
+                                                    &elapsed,
+                                                    &make_current_stats);
+        }
+
+        /* The contexts are made current on this thread to report on
+         * them */
+        if (run->workers)
+                stop_workers(run);
+
+        /* Interrupted before the first block finished */
+        if (frame_count <= 0)
+                return true;
+
+        session->n_runs++;
+
+        mct_report_begin_record(report, "run");
+        add_run_header_to_report(report, platform, config);
+        mct_report_add_int(report, "frames", frame_count);
+        mct_report_add_double(report, "seconds", elapsed);
+        mct_report_add_double(report, "fps", frame_count / elapsed);
+        mct_report_add_double(report,
+                              "context_frames_per_second",
+                              frame_count * config->n_contexts / elapsed);
+        /* Every frame draws all of the contexts */
+        mct_report_add_double(report, "fairness", 1.0);
+        mct_report_add_double(report,
+                              "switches_per_second",
+                              frame_count *
+                              get_switches_per_frame(config) /
+                              elapsed);
+        mct_report_add_double(report,
+                              "vertices_per_second",
+                              frame_count *
+                              (config->grid_width * 2.0 + 2.0) *
+                              config->grid_height *
+                              config->n_contexts /
+                              elapsed);
+        mct_report_add_double(report,
+                              "vertex_mb_per_second",
+                              frame_count *
+                              (double) get_frame_vertex_bytes(run) /
+                              elapsed /
+                              1e6);
+        add_stream_stats_to_report(report, run, frame_count, elapsed);
+        add_frame_stats_to_report(report, run->stats);
+        add_make_current_stats_to_report(report,
+                                         &make_current_stats,
+                                         frame_count);
+        add_init_stats_to_report(report, run);
+        if (config->memory)
+                add_memory_stats_to_report(report, run);
+        if (run->pool)
+                add_pool_stats_to_report(report, run, frame_count);
+        if (config->verify) {
+                readback_stats = run->evicted_readback_stats;
+                for (i = 0; i < config->n_contexts; i++) {
+                        draw_state = run->context_states[i].draw_state;
+                        if (draw_state == NULL)
+                                continue;
+                        /* Getting the stats checks the pending reads */
+                        mct_window_make_current(run->context_states[i].
+                                                window);
+                        readback_stats_add(&readback_stats,
+                                           mct_draw_state_get_readback_stats(
+                                                   draw_state));
+                }
+                verified = add_readback_stats_to_report(report,
+                                                        &readback_stats,
+                                                        frame_count);
+        }
+        if (session->baseline)
+                add_baseline_to_report(session, config, frame_count / elapsed);
+        mct_report_end_record(report);
+
+        report_contexts(report,
+                        platform,
+                        config,
+                        run->context_states,
+                        run->stats->perf,
+                        frame_count);
+
+        return verified;
+}
+
+static bool
+check_config(const struct mct_config *config,
+             bool sweep)
+{
+        if ((config->sync == MCT_SYNC_FENCE_SERVER ||
+             config->sync == MCT_SYNC_FENCE_CLIENT) &&
+            !config->share) {
+                fprintf(stderr,
+                        "Fence sync needs the contexts to be shared%s\n",
+                        sweep ? ", skipping" : "");
+                return false;
+        }
+
+        if (config->uniforms == MCT_UNIFORMS_SHARED_UBO && !config->share) {
+                fprintf(stderr,
+                        "A shared uniform buffer needs the contexts to be "
+                        "shared%s\n",
+                        sweep ? ", skipping" : "");
+                return false;
+        }
+
+        if (config->mode == MCT_MODE_PROCESS && config->share) {
+                fprintf(stderr,
+                        "Contexts in separate processes can't be shared%s\n",
+                        sweep ? ", skipping" : "");
+                return false;
+        }
+
+        /* The rings are in this process so the workers' events would
+         * be lost */
+        if (config->mode == MCT_MODE_PROCESS && mct_trace_is_enabled()) {
+                fprintf(stderr,
+                        "Contexts in separate processes can't be "
+                        "traced%s\n",
+                        sweep ? ", skipping" : "");
+                return false;
+        }
+
+        /* The shared objects would be lost whenever the context that
+         * owns them is recycled */
+        if (config->mode == MCT_MODE_POOL && config->share) {
+                fprintf(stderr,
+                        "Contexts in a pool can't be shared%s\n",
+                        sweep ? ", skipping" : "");
+                return false;
+        }
+
+        return true;
+}
+
+static bool
+init_run(struct mct_run *run,
+         struct mct_display *display,
+         struct mct_config *config,
+         bool dump_all,
+         FILE *info_out)
+{
+        struct mct_context_state *context_states;
+        struct shader_data_cache_stats cache_stats;
+        int i;
+
+        context_states = malloc(sizeof *context_states * config->n_contexts);
+
+        for (i = 0; i < MCT_N_MEMORY_STAGES; i++)
+                mct_memory_usage_init(run->memory + i);
+        if (config->memory)
+                sample_memory(&run->start_memory);
+
+        shader_data_get_cache_stats(&cache_stats);
+        run->init_rss = mct_memory_get_rss();
+        run->init_time = mct_get_time_ns();
+
+        run->pool = NULL;
+        run->state_init_time = NULL;
+        memset(&run->evicted_readback_stats,
+               0,
+               sizeof run->evicted_readback_stats);
+
+        if (config->mode == MCT_MODE_POOL) {
+                /* The contexts are only created when they are first
+                 * drawn */
+                run->pool = mct_pool_new(display,
+                                         config->width, config->height,
+                                         config->flush_on_release,
+                                         config->target ==
+                                         MCT_TARGET_SURFACELESS,
+                                         config->n_contexts,
+                                         config->pool_size);
+                run->state_init_time = malloc(sizeof *run->state_init_time);
+                mct_histogram_init(run->state_init_time);
+
+                for (i = 0; i < config->n_contexts; i++) {
+                        context_states[i].window = NULL;
+                        init_context_state(context_states + i, i);
+                }
+        } else if (!init_contexts(display,
+                                  config,
+                                  context_states,
+                                  config->memory ? run->memory : NULL)) {
+                free(context_states);
+                return false;
+        }
+
+        run->init_time = mct_get_time_ns() - run->init_time;
+        run->init_rss = mct_memory_get_rss() - run->init_rss;
+        shader_data_get_cache_stats(&run->cache_stats);
+        run->cache_stats.hits -= cache_stats.hits;
+        run->cache_stats.misses -= cache_stats.misses;
+        run->cache_stats.rejected -= cache_stats.rejected;
+
+        for (i = 0; i < config->n_contexts && run->pool == NULL; i++) {
+                mct_window_show(context_states[i].window);
+                if (dump_all || i == 0) {
+                        mct_window_make_current(context_states[i].window);
+                        dump_release_behavior(info_out);
+                }
+        }
+
+        if (config->memory)
+                sample_memory(&run->init_memory);
+
+        run->display = display;
+        run->config = config;
+        run->context_states = context_states;
+        run->workers = NULL;
+
+        /* The histograms are preallocated so that nothing needs to be
+         * allocated while measuring */
+        run->stats = malloc(sizeof *run->stats);
+        frame_stats_init(run->stats);
+        run->stats->perf = NULL;
+
+        if (config->perf_counters) {
+                run->stats->perf = mct_perf_new();
+                if (run->stats->perf == NULL) {
+                        fprintf(stderr,
+                                "note: no CPU performance counters are "
+                                "available\n");
+                }
+        }
+
+        /* The threads are kept for the whole run so that creating
+         * them isn't measured by each block */
+        if (config->mode == MCT_MODE_THREADED)
+                start_workers(run);
+
+        return true;
+}
+
+static void
+destroy_pool_contexts(struct mct_run *run)
+{
+        struct mct_context_state *context_state;
+        int i;
+
+        for (i = 0; i < run->config->n_contexts; i++) {
+                context_state = run->context_states + i;
+
+                if (context_state->draw_state == NULL)
+                        continue;
+
+                mct_window_make_current(context_state->window);
+                mct_draw_state_free(context_state->draw_state);
+        }
+
+        mct_pool_free(run->pool);
+}
+
+static void
+fini_run(struct mct_run *run)
+{
+        if (run->workers)
+                stop_workers(run);
+
+        if (run->stats->perf)
+                mct_perf_free(run->stats->perf);
+        free(run->stats);
+
+        if (run->pool) {
+                destroy_pool_contexts(run);
+                free(run->state_init_time);
+        } else {
+                destroy_contexts(run->context_states,
+                                 run->config->n_contexts);
+        }
+        free(run->context_states);
+}
+
+static int
+run_process_worker(const char *value)
+{
+        struct mct_process_control *control;
+        struct mct_process_worker *worker;
+        struct mct_display *display;
+        struct mct_config config;
+        struct mct_run run;
+        long long frame_count = 0;
+        uint64_t frame_start;
+        int index;
+
+        /* The main process tells the workers when to stop */
+        signal(SIGINT, SIG_IGN);
+        signal(SIGTERM, SIG_IGN);
+
+        control = mct_process_worker_map(value, &index);
+        if (control == NULL)
+                return EXIT_FAILURE;
+
+        worker = control->workers + index;
+        config = control->config;
+        config.n_contexts = 1;
+
+        display = mct_display_open(control->platform);
+        if (display == NULL)
+                return EXIT_FAILURE;
+
+        if (!init_run(&run, display, &config, false, stderr)) {
+                mct_display_close(display);
+                return EXIT_FAILURE;
+        }
+
+        mct_display_set_make_current_cache(display, config.make_current_cache);
+
+        __sync_synchronize();
+        worker->ready = true;
+
+        while (!control->start && !control->stop)
+                usleep(100);
+
+        worker->start_time = mct_get_time_ns();
+
+        while (!control->stop &&
+               (control->max_frames <= 0 ||
+                frame_count < control->max_frames)) {
+                frame_start = mct_get_time_ns();
+                draw_context(&config, run.context_states, run.stats);
+                mct_histogram_add(run.stats->phases + MCT_PHASE_FRAME,
+                                  mct_get_time_ns() - frame_start);
+                worker->frame_count = ++frame_count;
+        }
+
+        worker->end_time = mct_get_time_ns();
+        worker->stats = *run.stats;
+        worker->stats.perf = NULL;
+        if (config.verify) {
+                worker->readback_stats =
+                        *mct_draw_state_get_readback_stats(run.
+                                                           context_states[0].
+                                                           draw_state);
+        }
+        __sync_synchronize();
+        worker->done = true;
+
+        fini_run(&run);
+        mct_display_close(display);
+        mct_process_worker_unmap(control);
+
+        return EXIT_SUCCESS;
+}
+
+static bool
+wait_for_process_workers(struct mct_process_group *group,
+                         struct mct_process_control *control,
+                         int n_workers)
+{
+        int i;
+
+        for (i = 0; i < n_workers; i++) {
+                while (!control->workers[i].ready) {
+                        if (interrupted ||
+                            mct_process_group_has_exited(group))
+                                return false;
+                        usleep(1000);
+                }
+        }
+
+        return true;
+}
+
+static long long
+get_process_frame_count(struct mct_process_control *control,
+                        int n_workers,
+                        bool *all_done)
+{
+        long long frame_count = 0;
+        int i;
+
+        *all_done = true;
+
+        for (i = 0; i < n_workers; i++) {
+                frame_count += control->workers[i].frame_count;
+                if (!control->workers[i].done)
+                        *all_done = false;
+        }
+
+        return frame_count;
+}
+
+/* Lets the workers run until the limits are reached or the run is
+ * interrupted */
+static void
+supervise_process_workers(struct mct_session *session,
+                          struct mct_process_group *group,
+                          struct mct_process_control *control,
+                          int n_workers)
+{
+        bool limited = session->duration > 0.0 || session->max_frames > 0;
+        FILE *out = get_info_out(session->report);
+        uint64_t start_time = mct_get_time_ns(), now;
+        uint64_t last_time = start_time;
+        long long frame_count, last_frame_count = 0;
+        bool all_done;
+
+        while (!interrupted) {
+                usleep(1000);
+
+                now = mct_get_time_ns();
+                frame_count = get_process_frame_count(control,
+                                                      n_workers,
+                                                      &all_done);
+
+                if (all_done || mct_process_group_has_exited(group))
+                        break;
+
+                if (session->duration > 0.0 &&
+                    now - start_time >= session->duration * 1e9)
+                        break;
+
+                if (!limited && now - last_time >= UINT64_C(1000000000)) {
+                        fprintf(out,
+                                "FPS = %i (context frames per second = "
+                                "%.1f)\n",
+                                (int) ((frame_count - last_frame_count) *
+                                       1e9 / (now - last_time) /
+                                       n_workers +
+                                       0.5),
+                                (frame_count - last_frame_count) *
+                                1e9 / (now - last_time));
+                        fflush(out);
+                        last_time = now;
+                        last_frame_count = frame_count;
+                }
+        }
+}
+
+/* Returns false if any of the frames were drawn wrongly */
+static bool
+report_process_workers(struct mct_session *session,
+                       struct mct_config *config,
+                       struct mct_process_control *control)
+{
+        struct mct_report *report = session->report;
+        const struct mct_process_worker *worker;
+        struct mct_readback_stats readback_stats = { 0 };
+        struct mct_frame_stats *stats;
+        bool verified = true;
+        double worker_elapsed, elapsed = 0.0;
+        double fps[config->n_contexts];
+        double fps_sum = 0.0, fps_sum_squares = 0.0;
+        long long frame_count = 0;
+        int i;
+
+        stats = malloc(sizeof *stats);
+        frame_stats_init(stats);
+        stats->perf = NULL;
+
+        /* The workers' counters are gone by now. The same counters
+         * can be opened in this process on the same machine so these
+         * are only used to tell which of the totals to report. */
+        if (config->perf_counters)
+                stats->perf = mct_perf_new();
+
+        for (i = 0; i < config->n_contexts; i++) {
+                worker = control->workers + i;
+                worker_elapsed = (worker->end_time - worker->start_time) / 1e9;
+
+                fps[i] = worker_elapsed > 0.0 ?
+                        worker->frame_count / worker_elapsed :
+                        0.0;
+                fps_sum += fps[i];
+                fps_sum_squares += fps[i] * fps[i];
+                frame_count += worker->frame_count;
+
+                if (worker_elapsed > elapsed)
+                        elapsed = worker_elapsed;
+
+                frame_stats_merge(stats, &worker->stats);
+                readback_stats_add(&readback_stats, &worker->readback_stats);
+        }
+
+        session->n_runs++;
+
+        mct_report_begin_record(report, "run");
+        add_run_header_to_report(report, session->platform, config);
+        mct_report_add_int(report,
+                           "frames",
+                           frame_count / config->n_contexts);
+        mct_report_add_double(report, "seconds", elapsed);
+        /* A frame is one frame from each of the contexts to compare
+         * with the other modes */
+        mct_report_add_double(report, "fps", fps_sum / config->n_contexts);
+        mct_report_add_double(report, "context_frames_per_second", fps_sum);
+        /* Jain's fairness index. 1 means every context got the same
+         * frame rate and 1/n means one context got all of it. */
+        mct_report_add_double(report,
+                              "fairness",
+                              fps_sum_squares > 0.0 ?
+                              fps_sum * fps_sum /
+                              (config->n_contexts * fps_sum_squares) :
+                              0.0);
+        add_frame_stats_to_report(report, stats);
+        if (config->verify) {
+                verified = add_readback_stats_to_report(report,
+                                                        &readback_stats,
+                                                        frame_count /
+                                                        config->n_contexts);
+        }
+        if (session->baseline) {
+                add_baseline_to_report(session,
+                                       config,
+                                       fps_sum / config->n_contexts);
+        }
+        mct_report_end_record(report);
+
+        for (i = 0; i < config->n_contexts; i++) {
+                mct_report_begin_record(report, "context");
+                add_run_header_to_report(report, session->platform, config);
+                mct_report_add_int(report, "context", i);
+                mct_report_add_int(report,
+                                   "frames",
+                                   control->workers[i].frame_count);
+                mct_report_add_double(report, "fps", fps[i]);
+                mct_report_end_record(report);
+        }
+
+        if (stats->perf)
+                mct_perf_free(stats->perf);
+        free(stats);
+
+        return verified;
+}
+
+/* Runs each context in its own process with the same per-context
+ * loop as the threaded mode */
+static bool
+run_processes(struct mct_session *session,
+              struct mct_config *config)
+{
+        struct mct_process_group *group;
+        struct mct_process_control *control;
+        int n_workers = config->n_contexts;
+        bool ret;
+
+        group = mct_process_group_new(sizeof *control +
+                                      sizeof control->workers[0] * n_workers);
+        if (group == NULL)
+                return false;
+
+        control = mct_process_group_get_shared(group);
+        control->platform = session->platform;
+        control->config = *config;
+        control->max_frames = session->max_frames;
+
+        ret = (mct_process_group_start(group,
+                                       PROCESS_WORKER_OPTION,
+                                       n_workers) &&
+               wait_for_process_workers(group, control, n_workers));
+
+        if (ret) {
+                __sync_synchronize();
+                control->start = true;
+                supervise_process_workers(session, group, control, n_workers);
+        }
+
+        control->stop = true;
+
+        if (!mct_process_group_wait(group))
+                ret = false;
+
+        if (ret && !report_process_workers(session, config, control))
+                ret = false;
+
+        mct_process_group_free(group);
+
+        return ret;
+}
+
+static bool
+run_config(struct mct_session *session,
+           struct mct_config *config,
+           bool sweep)
+{
+        struct mct_run run;
+        bool ret;
+
+        /* Don't fail the whole sweep because of an invalid
+         * combination */
+        if (!check_config(config, sweep))
+                return sweep;
+
+        if (config->mode == MCT_MODE_PROCESS)
+                return run_processes(session, config);
+
+        if (!init_run(&run,
+                      session->display,
+                      config,
+                      !sweep,
+                      get_info_out(session->report)))
+                return false;
+
+        ret = run_and_report(session, &run);
+
+        fini_run(&run);
+
+        return ret;
+}
+
+static uint64_t
+next_random(uint64_t *state)
+{
+        /* xorshift64 */
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+
+        return *state;
+}
+
+static void
+add_axis_value_to_report(struct mct_report *report,
+                         const char *key,
+                         const struct mct_axis *axis,
+                         int value)
+{
+        if (axis->names)
+                mct_report_add_string(report,
+                                      key,
+                                      get_axis_value_name(axis, value));
+        else
+                mct_report_add_int(report, key, value);
+}
+
+static void
+add_comparison_to_report(struct mct_report *report,
+                         enum mct_platform platform,
+                         struct mct_config *configs,
+                         const struct mct_axis *axis,
+                         const struct mct_sample_stats *stats,
+                         const struct mct_comparison *comparison,
+                         int n_blocks,
+                         double block_duration,
+                         uint64_t seed)
+{
+        char seed_string[19];
+
+        /* The seed uses all 64 bits so it would look negative as an
+         * int */
+        snprintf(seed_string, sizeof seed_string,
+                 "0x%016llx",
+                 (unsigned long long) seed);
+
+        mct_report_begin_record(report, "compare");
+        add_run_header_to_report(report, platform, configs + 0);
+        mct_report_add_string(report, "compare", axis->name);
+        add_axis_value_to_report(report, "a", axis, axis->values[0]);
+        add_axis_value_to_report(report, "b", axis, axis->values[1]);
+        mct_report_add_int(report, "blocks", n_blocks);
+        mct_report_add_double(report, "block_seconds", block_duration);
+        mct_report_add_string(report, "seed", seed_string);
+        mct_report_add_double(report, "a_fps_mean", stats[0].mean);
+        mct_report_add_double(report,
+                              "a_fps_stddev",
+                              sqrt(stats[0].variance));
+        mct_report_add_double(report, "b_fps_mean", stats[1].mean);
+        mct_report_add_double(report,
+                              "b_fps_stddev",
+                              sqrt(stats[1].variance));
+        mct_report_add_double(report,
+                              "fps_difference",
+                              comparison->difference);
+        mct_report_add_double(report,
+                              "fps_difference_ci_low",
+                              comparison->ci_low);
+        mct_report_add_double(report,
+                              "fps_difference_ci_high",
+                              comparison->ci_high);
+        mct_report_add_double(report,
+                              "relative_difference",
+                              stats[0].mean > 0.0 ?
+                              comparison->difference / stats[0].mean :
+                              0.0);
+        mct_report_add_double(report, "t", comparison->t);
+        mct_report_add_double(report, "df", comparison->df);
+        mct_report_add_double(report, "p_value", comparison->p_value);
+        mct_report_add_string(report,
+                              "significant",
+                              comparison->p_value < 1.0 - COMPARE_CONFIDENCE ?
+                              "yes" : "no");
+        mct_report_end_record(report);
+}
+
+/* Runs the two values of an axis against each other in the same
+ * process. Both sets of contexts are created up front and then
+ * measured in short blocks with the order of each pair of blocks
+ * chosen at random, so that drift such as thermal throttling affects
+ * both sides equally. */
+static bool
+run_compare(struct mct_session *session,
+            const struct mct_config *base_config,
+            const struct mct_axis *compare_axis,
+            double warmup,
+            int n_blocks)
+{
+        struct mct_report *report = session->report;
+        struct mct_config configs[2];
+        struct mct_run runs[2];
+        struct mct_sample_stats stats[2];
+        struct mct_comparison comparison;
+        double *samples[2];
+        double block_duration = session->duration / (n_blocks * 2);
+        double elapsed;
+        long long frame_count;
+        uint64_t seed, random_state;
+        int i, j, side, first;
+
+        for (i = 0; i < 2; i++) {
+                configs[i] = *base_config;
+
+                for (j = 0; j < N_AXES; j++) {
+                        *get_axis_member(configs + i, axes + j) =
+                                axes[j].values[0];
+                }
+
+                *get_axis_member(configs + i, compare_axis) =
+                        compare_axis->values[i];
+
+                if (!check_config(configs + i, false))
+                        return false;
+
+                if (configs[i].mode == MCT_MODE_PROCESS) {
+                        fprintf(stderr,
+                                "--compare doesn't support the process "
+                                "mode\n");
+                        return false;
+                }
+        }
+
+        for (i = 0; i < 2; i++) {
+                if (!init_run(runs + i,
+                              session->display,
+                              configs + i,
+                              false, /* dump_all */
+                              get_info_out(report))) {
+                        if (i > 0)
+                                fini_run(runs + 0);
+                        return false;
+                }
+        }
+
+        if (warmup > 0.0) {
+                for (i = 0; i < 2; i++)
+                        run_block(runs + i, warmup / 2.0, 0, &elapsed, NULL);
+        }
+
+        seed = mct_get_time_ns();
+        random_state = seed | 1;
+
+        for (i = 0; i < 2; i++)
+                samples[i] = malloc(sizeof *samples[i] * n_blocks);
+
+        for (i = 0; i < n_blocks; i++) {
+                first = next_random(&random_state) & 1;
+
+                for (j = 0; j < 2; j++) {
+                        side = first ^ j;
+                        frame_count = run_block(runs + side,
+                                                block_duration,
+                                                0, /* max_frames */
+                                                &elapsed,
+                                                NULL);
+                        samples[side][i] = frame_count / elapsed;
+                }
+
+                /* The block that was cut short is missing most of
+                 * one side so only the complete pairs are kept */
+                if (interrupted) {
+                        n_blocks = i;
+                        break;
+                }
+        }
+
+        if (n_blocks >= 2) {
+                for (i = 0; i < 2; i++)
+                        mct_stats_describe(samples[i], n_blocks, stats + i);
+
+                mct_stats_compare(stats + 0,
+                                  stats + 1,
+                                  COMPARE_CONFIDENCE,
+                                  &comparison);
+
+                add_comparison_to_report(report,
+                                         session->platform,
+                                         configs,
+                                         compare_axis,
+                                         stats,
+                                         &comparison,
+                                         n_blocks,
+                                         block_duration,
+                                         seed);
+        } else {
+                fprintf(stderr,
+                        "Interrupted before two blocks of each value "
+                        "finished\n");
+        }
+
+        for (i = 0; i < 2; i++)
+                free(samples[i]);
+
+        for (i = 1; i >= 0; i--)
+                fini_run(runs + i);
+
+        return n_blocks >= 2;
+}
+
+static bool
+run_sweep(struct mct_session *session,
+          const struct mct_config *base_config,
+          bool sweep)
+{
+        struct mct_config config = *base_config;
+        int indices[N_AXES] = { 0 };
+        bool ret = true;
+        int i;
+
+        while (true) {
+                for (i = 0; i < N_AXES; i++) {
+                        *get_axis_member(&config, axes + i) =
+                                axes[i].values[indices[i]];
+                }
+
+                if (!run_config(session, &config, sweep))
+                        ret = false;
+
+                if (interrupted)
+                        break;
+
+                /* Advance to the next combination with the last
+                 * axis changing fastest */
+                for (i = N_AXES - 1; i >= 0; i--) {
+                        if (++indices[i] < axes[i].n_values)
+                                break;
+                        indices[i] = 0;
+                }
+
+                if (i < 0)
+                        break;
+        }
+
+        if (session->baseline) {
+                mct_report_begin_record(session->report, "summary");
+                mct_report_add_int(session->report, "runs", session->n_runs);
+                mct_report_add_int(session->report,
+                                   "regressions",
+                                   session->n_regressions);
+                mct_report_add_int(session->report,
+                                   "missing_baselines",
+                                   session->n_missing_baselines);
+                mct_report_add_double(session->report,
+                                      "threshold_percent",
+                                      session->threshold);
+                mct_report_end_record(session->report);
+        }
+
+        return ret;
+}
+
+static bool
+add_axis_value(struct mct_axis *axis,
+               int value)
+{
+        if (value < axis->min_value)
+                return false;
+
+        axis->values = realloc(axis->values,
+                               sizeof axis->values[0] *
+                               (axis->n_values + 1));
+        axis->values[axis->n_values++] = value;
+
+        return true;
+}
+
+static bool
+parse_axis_item(struct mct_axis *axis,
+                const char *item)
+{
+        const struct mct_axis_name *name;
+        long start, end, step = 1;
+        bool multiply = false;
+        char *tail;
+
+        if (axis->names) {
+                for (name = axis->names; name->name; name++) {
+                        if (!strcmp(name->name, item))
+                                return add_axis_value(axis, name->value);
+                }
+
+                return false;
+        }
+
+        /* Either a single number, a range such as 10..1000 with an
+         * optional step size (10..1000:10) or a range with a
+         * multiplier (1..64*2) */
+
+        errno = 0;
+        start = strtol(item, &tail, 10);
+        if (errno || tail == item || start > INT_MAX)
+                return false;
+
+        if (*tail == '\0')
+                return add_axis_value(axis, start);
+
+        if (strncmp(tail, "..", 2))
+                return false;
+
+        item = tail + 2;
+        end = strtol(item, &tail, 10);
+        if (errno || tail == item || end > INT_MAX || end < start)
+                return false;
+
+        if (*tail == ':' || *tail == '*') {
+                multiply = *tail == '*';
+                item = tail + 1;
+                step = strtol(item, &tail, 10);
+                if (errno || tail == item || step < (multiply ? 2 : 1))
+                        return false;
+        }
+
+        if (*tail != '\0')
+                return false;
+
+        while (start <= end) {
+                if (!add_axis_value(axis, start))
+                        return false;
+
+                if (multiply) {
+                        if (start <= 0)
+                                return false;
+                        start *= step;
+                } else {
+                        start += step;
+                }
+        }
+
+        return true;
+}
+
+static bool
+parse_axis(struct mct_axis *axis,
+           const char *arg)
+{
+        char *copy = strdup(arg);
+        char *item, *saveptr;
+        bool ret = true;
+
+        axis->n_values = 0;
+        axis->given = true;
+
+        for (item = strtok_r(copy, ",", &saveptr);
+             item;
+             item = strtok_r(NULL, ",", &saveptr)) {
+                if (!parse_axis_item(axis, item)) {
+                        fprintf(stderr,
+                                "Invalid value “%s” for --%s\n",
+                                item,
+                                axis->name);
+                        ret = false;
+                        break;
+                }
+        }
+
+        free(copy);
+
+        return ret && axis->n_values > 0;
+}
+
+static char *
+get_default_cache_dir(void)
+{
+        const char *base = getenv("XDG_CACHE_HOME");
+        const char *suffix = "/multi-context-test";
+        char *dir;
+
+        if (base && *base) {
+                dir = malloc(strlen(base) + strlen(suffix) + 1);
+                sprintf(dir, "%s%s", base, suffix);
+        } else {
+                base = getenv("HOME");
+                if (base == NULL)
+                        base = ".";
+                dir = malloc(strlen(base) + strlen("/.cache") +
+                             strlen(suffix) + 1);
+                sprintf(dir, "%s/.cache%s", base, suffix);
+        }
+
+        return dir;
+}
+
+static void
+handle_interrupt(int signum)
+{
+        interrupted = true;
+}
+
+static void
+usage(void)
+{
+        const struct mct_axis_name *name;
+        const char *help, *end;
+        int i;
+
+        fprintf(stderr,
+                "usage: multi-context-test [options] [flush/none]\n"
+                "\n"
+                "  -p, --platform=glx/egl  Window system to use. EGL uses\n"
+                "                          pbuffers on a surfaceless or\n"
+                "                          device display and needs no\n"
+                "                          X server. (default glx)\n"
+                "  -d, --duration=SECONDS  Run each configuration for this\n"
+                "                          long and report the results\n"
+                "                          instead of running until\n"
+                "                          interrupted (default %g when\n"
+                "                          sweeping)\n"
+                "  -n, --frames=N          Stop each configuration after N\n"
+                "                          frames. With --duration the run\n"
+                "                          stops at whichever comes first\n"
+                "  -f, --format=FORMAT     Format of the results. One of\n"
+                "                          text, csv or json (default text)\n"
+                "  -g, --gpu-timing        Measure the GPU time of each\n"
+                "                          context with timer queries and\n"
+                "                          report it per context\n"
+                "  -t, --present-timing    Measure when each frame reaches\n"
+                "                          the screen with\n"
+                "                          GLX_OML_sync_control and report\n"
+                "                          it per context\n"
+                "  -P, --perf              Count CPU cycles, instructions,\n"
+                "                          cache misses and context switches\n"
+                "                          per phase and per context switch\n"
+                "                          on the drawing threads. The\n"
+                "                          driver's own threads aren't\n"
+                "                          counted\n"
+                "  -V, --verify            Read back every frame through a\n"
+                "                          ring of pixel buffers and compare\n"
+                "                          it with a reference render. The\n"
+                "                          band position then cycles through\n"
+                "                          a fixed set and any mismatch fails\n"
+                "                          the run\n"
+                "  -M, --memory            Sample the process and video\n"
+                "                          memory while each context is set\n"
+                "                          up and report how much every\n"
+                "                          context costs\n"
+                "  -C, --compare[=AXIS]    Compare the two values given for\n"
+                "                          AXIS in interleaved blocks and\n"
+                "                          test whether the frame rates\n"
+                "                          differ. (default AXIS release\n"
+                "                          with none,flush)\n"
+                "  -b, --blocks=N          Number of blocks of each value to\n"
+                "                          run when comparing (default %i)\n"
+                "  -w, --warmup=SECONDS    Time to run both values before\n"
+                "                          comparing (default %g)\n"
+                "  -c, --program-cache[=DIR]\n"
+                "                          Cache linked program binaries\n"
+                "                          in DIR so that later runs skip\n"
+                "                          compiling. (default DIR\n"
+                "                          $XDG_CACHE_HOME/multi-context-test)\n"
+                "  -T, --trace=FILE        Record every make current, draw,\n"
+                "                          and swap and write them to FILE\n"
+                "                          as a Chrome trace when the run\n"
+                "                          finishes\n"
+                "  -B, --baseline=FILE     Compare the frame rate of each\n"
+                "                          run with the same run in FILE,\n"
+                "                          which is saved text output, and\n"
+                "                          exit with status %i if any is\n"
+                "                          slower than the threshold. Runs\n"
+                "                          are matched on the platform and\n"
+                "                          the options given, and a run\n"
+                "                          missing from FILE is an error\n"
+                "  -R, --threshold=PERCENT How far below the baseline a run\n"
+                "                          can be before it is a regression\n"
+                "                          (default %g)\n"
+                "  -h, --help              Show this help\n"
+                "\n"
+                "The following options take a comma-separated list of\n"
+                "values. Integer options also accept ranges such as\n"
+                "10..1000 or 10..1000:10 (a step size) or 1..64*2 (a\n"
+                "multiplier). If more than one value is given then every\n"
+                "combination of the values is run.\n"
+                "\n",
+                DEFAULT_SWEEP_DURATION,
+                DEFAULT_COMPARE_BLOCKS,
+                DEFAULT_COMPARE_WARMUP,
+                EXIT_REGRESSION,
+                DEFAULT_REGRESSION_THRESHOLD);
+
+        for (i = 0; i < N_AXES; i++) {
+                fprintf(stderr, "  --%s=", axes[i].name);
+
+                if (axes[i].names) {
+                        for (name = axes[i].names; name->name; name++) {
+                                fprintf(stderr, "%s%s",
+                                        name == axes[i].names ? "" : "/",
+                                        name->name);
+                        }
+                } else {
+                        fprintf(stderr, "LIST");
+                }
+
+                fprintf(stderr, "\n");
+
+                for (help = axes[i].help; *help; help = end) {
+                        end = strchr(help, '\n');
+                        if (end == NULL)
+                                end = help + strlen(help);
+                        fprintf(stderr,
+                                "        %.*s\n",
+                                (int) (end - help), help);
+                        if (*end)
+                                end++;
+                }
+
+                if (axes[i].names) {
+                        for (name = axes[i].names; name->name; name++) {
+                                if (name->value == axes[i].default_value)
+                                        break;
+                        }
+                        fprintf(stderr, "        (default %s)\n", name->name);
+                } else {
+                        fprintf(stderr,
+                                "        (default %i)\n",
+                                axes[i].default_value);
+                }
+        }
+
+        exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+        static const struct option base_options[] = {
+                { "platform", required_argument, NULL, 'p' },
+                { "duration", required_argument, NULL, 'd' },
+                { "format", required_argument, NULL, 'f' },
+                { "gpu-timing", no_argument, NULL, 'g' },
+                { "present-timing", no_argument, NULL, 't' },
+                { "perf", no_argument, NULL, 'P' },
+                { "verify", no_argument, NULL, 'V' },
+                { "memory", no_argument, NULL, 'M' },
+                { "compare", optional_argument, NULL, 'C' },
+                { "blocks", required_argument, NULL, 'b' },
+                { "warmup", required_argument, NULL, 'w' },
+                { "program-cache", optional_argument, NULL, 'c' },
+                { "trace", required_argument, NULL, 'T' },
+                { "frames", required_argument, NULL, 'n' },
+                { "baseline", required_argument, NULL, 'B' },
+                { "threshold", required_argument, NULL, 'R' },
+                /* Used internally to start the process mode workers */
+                { PROCESS_WORKER_OPTION, required_argument, NULL, 'W' },
+                { "help", no_argument, NULL, 'h' },
+        };
+        const int n_base_options =
+                sizeof base_options / sizeof base_options[0];
+        struct option long_options[n_base_options + N_AXES + 1];
+        enum mct_report_format format = MCT_REPORT_FORMAT_TEXT;
+        struct mct_config base_config = { 0 };
+        struct mct_session session = {
+                .platform = MCT_PLATFORM_GLX,
+                .threshold = DEFAULT_REGRESSION_THRESHOLD,
+        };
+        struct sigaction action;
+        char *program_cache_dir = NULL;
+        const char *trace_filename = NULL;
+        const char *baseline_filename = NULL;
+        struct mct_axis *compare_axis = NULL;
+        int n_blocks = DEFAULT_COMPARE_BLOCKS;
+        double warmup = DEFAULT_COMPARE_WARMUP;
+        bool sweep = false;
+        bool ret;
+        char *tail;
+        int i, opt;
+
+        memcpy(long_options, base_options, sizeof base_options);
+
+        for (i = 0; i < N_AXES; i++) {
+                long_options[n_base_options + i].name = axes[i].name;
+                long_options[n_base_options + i].has_arg = required_argument;
+                long_options[n_base_options + i].flag = NULL;
+                long_options[n_base_options + i].val = 256 + i;
+        }
+
+        memset(long_options + n_base_options + N_AXES,
+               0,
+               sizeof long_options[0]);
+
+        while ((opt = getopt_long(argc, argv, "p:d:f:gtPVMC::b:w:c::T:n:B:R:h",
+                                  long_options, NULL)) != -1) {
+                switch (opt) {
+                case 'p':
+                        if (!mct_platform_from_string(optarg,
+                                                      &session.platform))
+                                usage();
+                        break;
+                case 'd':
+                        session.duration = strtod(optarg, &tail);
+                        if (*tail || session.duration <= 0.0)
+                                usage();
+                        break;
+                case 'f':
+                        if (!mct_report_format_from_string(optarg, &format))
+                                usage();
+                        break;
+                case 'g':
+                        base_config.gpu_timing = true;
+                        break;
+                case 't':
+                        base_config.present_timing = true;
+                        break;
+                case 'P':
+                        base_config.perf_counters = true;
+                        break;
+                case 'V':
+                        base_config.verify = true;
+                        break;
+                case 'M':
+                        base_config.memory = true;
+                        break;
+                case 'C':
+                        compare_axis = find_axis(optarg ? optarg : "release");
+                        if (compare_axis == NULL)
+                                usage();
+                        break;
+                case 'b':
+                        n_blocks = strtol(optarg, &tail, 10);
+                        if (*tail || n_blocks < 2)
+                                usage();
+                        break;
+                case 'w':
+                        warmup = strtod(optarg, &tail);
+                        if (*tail || warmup < 0.0)
+                                usage();
+                        break;
+                case 'c':
+                        free(program_cache_dir);
+                        if (optarg)
+                                program_cache_dir = strdup(optarg);
+                        else
+                                program_cache_dir = get_default_cache_dir();
+                        break;
+                case 'T':
+                        trace_filename = optarg;
+                        break;
+                case 'n':
+                        session.max_frames = strtoll(optarg, &tail, 10);
+                        if (*tail || session.max_frames <= 0)
+                                usage();
+                        break;
+                case 'B':
+                        baseline_filename = optarg;
+                        break;
+                case 'R':
+                        session.threshold = strtod(optarg, &tail);
+                        if (*tail || session.threshold < 0.0)
+                                usage();
+                        break;
+                case 'W':
+                        return run_process_worker(optarg);
+                default:
+                        if (opt >= 256 && opt < 256 + N_AXES) {
+                                if (!parse_axis(axes + opt - 256, optarg))
+                                        usage();
+                        } else {
+                                usage();
+                        }
+                }
+        }
+
+        if (optind + 1 == argc) {
+                /* For compatibility the release behavior can be given
+                 * without an option name */
+                if (!parse_axis(find_axis("release"), argv[optind]))
+                        usage();
+        } else if (optind != argc) {
+                usage();
+        }
+
+        if (compare_axis &&
+            compare_axis->n_values == 0 &&
+            !strcmp(compare_axis->name, "release")) {
+                add_axis_value(compare_axis, false);
+                add_axis_value(compare_axis, true);
+        }
+
+        for (i = 0; i < N_AXES; i++) {
+                if (axes + i == compare_axis) {
+                        if (axes[i].n_values != 2) {
+                                fprintf(stderr,
+                                        "--compare needs exactly two "
+                                        "values for --%s\n",
+                                        axes[i].name);
+                                return EXIT_FAILURE;
+                        }
+                } else if (axes[i].n_values == 0) {
+                        add_axis_value(axes + i, axes[i].default_value);
+                } else if (axes[i].n_values > 1) {
+                        sweep = true;
+                }
+        }
+
+        if (compare_axis && sweep) {
+                fprintf(stderr, "--compare can't be combined with a sweep\n");
+                return EXIT_FAILURE;
+        }
+
+        if (compare_axis && (session.max_frames > 0 || baseline_filename)) {
+                fprintf(stderr,
+                        "--compare can't be combined with --frames or "
+                        "--baseline\n");
+                return EXIT_FAILURE;
+        }
+
+        if (session.duration <= 0.0) {
+                if (compare_axis)
+                        session.duration = DEFAULT_COMPARE_DURATION;
+                else if (sweep && session.max_frames <= 0)
+                        session.duration = DEFAULT_SWEEP_DURATION;
+        }
+
+        if (baseline_filename) {
+                session.baseline = mct_baseline_load(baseline_filename);
+                if (session.baseline == NULL)
+                        return EXIT_FAILURE;
+        }
+
+        if (trace_filename) {
+                mct_trace_init(TRACE_EVENTS_PER_THREAD);
+                mct_trace_set_thread("main");
+        }
+
+        /* Let the current run finish and report on the first signal
+         * but still allow a second one to kill the program */
+        memset(&action, 0, sizeof action);
+        action.sa_handler = handle_interrupt;
+        action.sa_flags = SA_RESETHAND | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        if (program_cache_dir) {
+                if (!shader_data_set_program_cache_dir(program_cache_dir))
+                        return EXIT_FAILURE;
+                free(program_cache_dir);
+        }
+
+        session.display = mct_display_open(session.platform);
+
+        if (session.display == NULL)
+                return EXIT_FAILURE;
+
+        session.report = mct_report_new(format, stdout);
+
+        if (compare_axis) {
+                ret = run_compare(&session,
+                                  &base_config,
+                                  compare_axis,
+                                  warmup,
+                                  n_blocks);
+        } else {
+                ret = run_sweep(&session, &base_config, sweep);
+        }
+
+        mct_report_free(session.report);
+
+        mct_display_close(session.display);
+
+        if (session.baseline)
+                mct_baseline_free(session.baseline);
+
+        if (trace_filename) {
+                if (!mct_trace_write(trace_filename))
+                        ret = false;
+                mct_trace_fini();
+        }
+
+        for (i = 0; i < N_AXES; i++)
+                free(axes[i].values);
+
+        if (!ret)
+                return EXIT_FAILURE;
+
+        if (session.n_regressions > 0)
+                return EXIT_REGRESSION;
+
+        /* A run that can't be checked mustn't pass the check */
+        if (session.n_missing_baselines > 0) {
+                fprintf(stderr,
+                        "%i runs had no baseline\n",
+                        session.n_missing_baselines);
+                return EXIT_FAILURE;
+        }
 
         return EXIT_SUCCESS;
 }
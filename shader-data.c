@@ -33,6 +33,11 @@
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "shader-data.h"
 
@@ -90,29 +95,71 @@ shader_data_load_shader_source(const char *filename)
         return source;
 }
 
-GLuint
-shader_data_load_shader(GLenum type,
-                        const char *filename)
-{
-        GLuint shader;
-        GLint length, compile_status;
-        GLsizei actual_length;
+static char *program_cache_dir = NULL;
+static struct shader_data_cache_stats cache_stats;
+/* Programs may be loaded from multiple threads at once */
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int tmp_file_counter = 0;
+
+#define MAX_SHADERS 8
+#define CACHE_MAGIC 0x4243544d /* “MTCB” */
+
+struct shader_data_source {
+        GLenum type;
+        const char *filename;
         char *source;
-        GLchar *info_log;
+};
 
-        source = shader_data_load_shader_source(filename);
-        if (source == NULL)
-                return 0;
+struct shader_data_program {
+        GLuint program;
+
+        /* Shaders that are still attached to the program while it is
+         * being compiled. This is empty if the program came from the
+         * cache */
+        int n_shaders;
+        GLuint shaders[MAX_SHADERS];
+        const char *filenames[MAX_SHADERS];
+
+        /* Set if the binary should be saved once it is linked */
+        char *cache_filename;
+
+        /* Whether the driver is compiling in the background */
+        bool parallel;
+};
+
+struct cache_header {
+        uint32_t magic;
+        uint32_t format;
+        uint32_t length;
+};
+
+static GLuint
+start_compile(GLenum type,
+              const char *source)
+{
+        GLuint shader;
+        GLint length;
 
         length = strlen(source);
 
         shader = glCreateShader(type);
         glShaderSource(shader, 1, (const GLchar **) &source, &length);
 
-        free(source);
-
+        /* This doesn't wait for the compilation to finish if the
+         * driver can compile in the background */
         glCompileShader(shader);
 
+        return shader;
+}
+
+static bool
+check_shader(GLuint shader,
+             const char *filename)
+{
+        GLint length, compile_status;
+        GLsizei actual_length;
+        GLchar *info_log;
+
         glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
 
         if (length > 0) {
@@ -131,6 +178,28 @@ shader_data_load_shader(GLenum type,
 
         if (!compile_status) {
                 fprintf(stderr, "%s: compilation failed\n", filename);
+                return false;
+        }
+
+        return true;
+}
+
+GLuint
+shader_data_load_shader(GLenum type,
+                        const char *filename)
+{
+        GLuint shader;
+        char *source;
+
+        source = shader_data_load_shader_source(filename);
+        if (source == NULL)
+                return 0;
+
+        shader = start_compile(type, source);
+
+        free(source);
+
+        if (!check_shader(shader, filename)) {
                 glDeleteShader(shader);
                 return 0;
         }
@@ -138,45 +207,298 @@ shader_data_load_shader(GLenum type,
         return shader;
 }
 
-GLuint
-shader_data_load_program(GLenum shader_type,
-                         ...)
+static bool
+make_directory(const char *path)
 {
-        GLint length, link_status;
-        GLsizei actual_length;
-        GLchar *info_log;
+        if (mkdir(path, 0777) == -1 && errno != EEXIST) {
+                fprintf(stderr, "%s: %s\n", path, strerror(errno));
+                return false;
+        }
+
+        return true;
+}
+
+static bool
+make_directories(const char *path)
+{
+        char *copy = strdup(path);
+        char *p;
+        bool ret = true;
+
+        for (p = strchr(copy + 1, '/'); p; p = strchr(p + 1, '/')) {
+                *p = '\0';
+                ret = make_directory(copy);
+                *p = '/';
+                if (!ret)
+                        break;
+        }
+
+        if (ret)
+                ret = make_directory(copy);
+
+        free(copy);
+
+        return ret;
+}
+
+bool
+shader_data_set_program_cache_dir(const char *dir)
+{
+        free(program_cache_dir);
+        program_cache_dir = NULL;
+
+        if (dir == NULL)
+                return true;
+
+        if (!make_directories(dir))
+                return false;
+
+        program_cache_dir = strdup(dir);
+
+        return true;
+}
+
+void
+shader_data_get_cache_stats(struct shader_data_cache_stats *stats)
+{
+        pthread_mutex_lock(&cache_mutex);
+        *stats = cache_stats;
+        pthread_mutex_unlock(&cache_mutex);
+}
+
+static int
+locked_increment(int *stat)
+{
+        int value;
+
+        pthread_mutex_lock(&cache_mutex);
+        value = (*stat)++;
+        pthread_mutex_unlock(&cache_mutex);
+
+        return value;
+}
+
+static void
+hash_data(uint64_t *hash,
+          const void *data,
+          size_t length)
+{
+        const uint8_t *p = data;
+        size_t i;
+
+        /* 64-bit FNV-1a */
+        for (i = 0; i < length; i++) {
+                *hash ^= p[i];
+                *hash *= UINT64_C(0x100000001b3);
+        }
+}
+
+static void
+hash_string(uint64_t *hash,
+            const char *str)
+{
+        /* Include the terminator so that concatenations don't
+         * collide */
+        hash_data(hash, str ? str : "", strlen(str ? str : "") + 1);
+}
+
+static char *
+get_cache_filename(const struct shader_data_source *sources,
+                   int n_sources)
+{
+        uint64_t hash = UINT64_C(0xcbf29ce484222325);
+        uint32_t type;
+        char *filename;
+        int i;
+
+        /* A binary is only valid for the driver that created it so
+         * the driver's identity is part of the key */
+        hash_string(&hash, (const char *) glGetString(GL_VENDOR));
+        hash_string(&hash, (const char *) glGetString(GL_RENDERER));
+        hash_string(&hash, (const char *) glGetString(GL_VERSION));
+
+        for (i = 0; i < n_sources; i++) {
+                type = sources[i].type;
+                hash_data(&hash, &type, sizeof type);
+                hash_string(&hash, sources[i].source);
+        }
+
+        filename = malloc(strlen(program_cache_dir) + 1 + 16 + 4 + 1);
+        sprintf(filename,
+                "%s/%016" PRIx64 ".bin",
+                program_cache_dir,
+                hash);
+
+        return filename;
+}
+
+static bool
+program_binary_supported(void)
+{
+        GLint n_formats;
+
+        if (epoxy_gl_version() < 41 &&
+            !epoxy_has_gl_extension("GL_ARB_get_program_binary"))
+                return false;
+
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+
+        return n_formats > 0;
+}
+
+static GLuint
+load_cached_program(const char *filename)
+{
+        struct cache_header header;
+        GLint link_status;
         GLuint program;
-        GLuint shader;
-        va_list ap;
+        FILE *file;
+        void *binary;
 
-        va_start(ap, shader_type);
+        file = fopen(filename, "rb");
+        if (file == NULL)
+                return 0;
+
+        if (fread(&header, sizeof header, 1, file) != 1 ||
+            header.magic != CACHE_MAGIC) {
+                fclose(file);
+                return 0;
+        }
+
+        binary = malloc(header.length);
+
+        if (fread(binary, 1, header.length, file) != header.length) {
+                free(binary);
+                fclose(file);
+                return 0;
+        }
+
+        fclose(file);
 
         program = glCreateProgram();
+        glProgramBinary(program, header.format, binary, header.length);
+        free(binary);
 
-        while (shader_type != GL_NONE) {
-                shader = shader_data_load_shader(shader_type,
-                                                 va_arg(ap, const char *));
-                if (shader == 0) {
-                        glDeleteProgram(program);
-                        va_end(ap);
-                        return 0;
-                }
+        /* The driver is allowed to reject the binary at any time,
+         * for example after an update, in which case the program is
+         * just rebuilt from source */
+        glGetProgramiv(program, GL_LINK_STATUS, &link_status);
 
-                glAttachShader(program, shader);
-                glDeleteShader(shader);
+        if (!link_status) {
+                glDeleteProgram(program);
+                locked_increment(&cache_stats.rejected);
+                return 0;
+        }
 
-                shader_type = va_arg(ap, GLenum);
+        return program;
+}
+
+static void
+save_cached_program(const char *filename,
+                    GLuint program)
+{
+        struct cache_header header;
+        GLint length;
+        GLenum format;
+        char *tmp_filename;
+        void *binary;
+        FILE *file;
+        bool ok;
+
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+                return;
+
+        binary = malloc(length);
+        glGetProgramBinary(program, length, &length, &format, binary);
+
+        header.magic = CACHE_MAGIC;
+        header.format = format;
+        header.length = length;
+
+        /* Write to a temporary file and rename it so that another
+         * process never sees a partial binary */
+        tmp_filename = malloc(strlen(filename) + 64);
+        sprintf(tmp_filename,
+                "%s.%li.%i.tmp",
+                filename,
+                (long) getpid(),
+                locked_increment(&tmp_file_counter));
+
+        file = fopen(tmp_filename, "wb");
+
+        if (file == NULL) {
+                fprintf(stderr, "%s: %s\n", tmp_filename, strerror(errno));
+        } else {
+                ok = (fwrite(&header, sizeof header, 1, file) == 1 &&
+                      fwrite(binary, 1, length, file) == length);
+
+                if (fclose(file) == 0 && ok)
+                        rename(tmp_filename, filename);
+                else
+                        unlink(tmp_filename);
         }
 
-        va_end(ap);
+        free(tmp_filename);
+        free(binary);
+}
 
-        glLinkProgram(program);
+static void
+start_link(struct shader_data_program *program,
+           const struct shader_data_source *sources,
+           int n_sources,
+           bool retrievable)
+{
+        GLuint shader;
+        int i;
 
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        program->program = glCreateProgram();
+
+        for (i = 0; i < n_sources; i++) {
+                shader = start_compile(sources[i].type, sources[i].source);
+                glAttachShader(program->program, shader);
+                program->shaders[i] = shader;
+                program->filenames[i] = sources[i].filename;
+        }
+
+        program->n_shaders = n_sources;
+
+        if (retrievable) {
+                glProgramParameteri(program->program,
+                                    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE);
+        }
+
+        glLinkProgram(program->program);
+}
+
+static bool
+check_link(struct shader_data_program *program)
+{
+        GLint length, link_status;
+        GLsizei actual_length;
+        GLchar *info_log;
+        bool ret = true;
+        int i;
+
+        /* Querying the status waits for the compilation to finish */
+        for (i = 0; i < program->n_shaders; i++) {
+                if (!check_shader(program->shaders[i],
+                                  program->filenames[i]))
+                        ret = false;
+        }
+
+        if (!ret)
+                return false;
+
+        glGetProgramiv(program->program, GL_INFO_LOG_LENGTH, &length);
 
         if (length > 0) {
                 info_log = malloc(length);
-                glGetProgramInfoLog(program, length, &actual_length, info_log);
+                glGetProgramInfoLog(program->program,
+                                    length,
+                                    &actual_length,
+                                    info_log);
                 if (*info_log) {
                         fprintf(stderr,
                                 "Link info log:\n%s\n",
@@ -185,13 +507,214 @@ shader_data_load_program(GLenum shader_type,
                 free(info_log);
         }
 
-        glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+        glGetProgramiv(program->program, GL_LINK_STATUS, &link_status);
 
         if (!link_status) {
                 fprintf(stderr, "program link failed\n");
-                glDeleteProgram(program);
-                return 0;
+                return false;
         }
 
+        return true;
+}
+
+bool
+shader_data_has_parallel_compile(void)
+{
+        return (epoxy_has_gl_extension("GL_KHR_parallel_shader_compile") ||
+                epoxy_has_gl_extension("GL_ARB_parallel_shader_compile"));
+}
+
+static char *
+add_defines(char *source,
+            const char *defines)
+{
+        const char *version, *line_end;
+        char *result;
+        int line_num = 1;
+        const char *p;
+        size_t prefix_length;
+
+        /* The defines have to come after the #version directive */
+        version = strstr(source, "#version");
+        if (version == NULL) {
+                line_end = source;
+        } else {
+                line_end = strchr(version, '\n');
+                if (line_end == NULL)
+                        line_end = version + strlen(version);
+                else
+                        line_end++;
+        }
+
+        for (p = source; p < line_end; p++) {
+                if (*p == '\n')
+                        line_num++;
+        }
+
+        prefix_length = line_end - source;
+
+        result = malloc(prefix_length + strlen(defines) + 32 +
+                        strlen(line_end) + 1);
+        memcpy(result, source, prefix_length);
+        /* Keep the line numbers in the info log matching the file */
+        sprintf(result + prefix_length,
+                "%s\n#line %i\n%s",
+                defines,
+                line_num,
+                line_end);
+
+        free(source);
+
+        return result;
+}
+
+static struct shader_data_program *
+submit_program_valist(const char *defines,
+                      GLenum shader_type,
+                      va_list ap)
+{
+        struct shader_data_source sources[MAX_SHADERS];
+        struct shader_data_program *program = NULL;
+        char *cache_filename = NULL;
+        GLuint cached_program;
+        int n_sources = 0;
+        int i;
+
+        while (shader_type != GL_NONE) {
+                if (n_sources >= MAX_SHADERS) {
+                        fprintf(stderr, "too many shaders\n");
+                        goto out;
+                }
+
+                sources[n_sources].type = shader_type;
+                sources[n_sources].filename = va_arg(ap, const char *);
+                sources[n_sources].source =
+                        shader_data_load_shader_source(sources[n_sources].
+                                                       filename);
+                if (sources[n_sources].source == NULL)
+                        goto out;
+
+                if (defines && *defines) {
+                        sources[n_sources].source =
+                                add_defines(sources[n_sources].source,
+                                            defines);
+                }
+
+                n_sources++;
+
+                shader_type = va_arg(ap, GLenum);
+        }
+
+        program = calloc(1, sizeof *program);
+
+        if (program_cache_dir && program_binary_supported()) {
+                cache_filename = get_cache_filename(sources, n_sources);
+                cached_program = load_cached_program(cache_filename);
+
+                if (cached_program) {
+                        locked_increment(&cache_stats.hits);
+                        program->program = cached_program;
+                        goto out;
+                }
+
+                locked_increment(&cache_stats.misses);
+
+                program->cache_filename = cache_filename;
+                cache_filename = NULL;
+        }
+
+        if (shader_data_has_parallel_compile()) {
+                /* Let the driver use as many threads as it likes */
+                glMaxShaderCompilerThreadsKHR(0xffffffff);
+                program->parallel = true;
+        }
+
+        start_link(program,
+                   sources,
+                   n_sources,
+                   program->cache_filename != NULL);
+
+out:
+        for (i = 0; i < n_sources; i++)
+                free(sources[i].source);
+
+        free(cache_filename);
+
+        return program;
+}
+
+struct shader_data_program *
+shader_data_submit_program(const char *defines,
+                           GLenum shader_type,
+                           ...)
+{
+        struct shader_data_program *program;
+        va_list ap;
+
+        va_start(ap, shader_type);
+        program = submit_program_valist(defines, shader_type, ap);
+        va_end(ap);
+
         return program;
 }
+
+bool
+shader_data_program_is_ready(struct shader_data_program *program)
+{
+        GLint completion_status;
+
+        /* Without the extension the status queries will just block
+         * so there's no point in polling */
+        if (!program->parallel || program->n_shaders == 0)
+                return true;
+
+        glGetProgramiv(program->program,
+                       GL_COMPLETION_STATUS_KHR,
+                       &completion_status);
+
+        return completion_status;
+}
+
+GLuint
+shader_data_finish_program(struct shader_data_program *program)
+{
+        GLuint ret = program->program;
+        int i;
+
+        if (program->n_shaders > 0) {
+                if (check_link(program)) {
+                        if (program->cache_filename)
+                                save_cached_program(program->cache_filename,
+                                                    ret);
+                } else {
+                        glDeleteProgram(ret);
+                        ret = 0;
+                }
+
+                for (i = 0; i < program->n_shaders; i++)
+                        glDeleteShader(program->shaders[i]);
+        }
+
+        free(program->cache_filename);
+        free(program);
+
+        return ret;
+}
+
+GLuint
+shader_data_load_program(const char *defines,
+                         GLenum shader_type,
+                         ...)
+{
+        struct shader_data_program *program;
+        va_list ap;
+
+        va_start(ap, shader_type);
+        program = submit_program_valist(defines, shader_type, ap);
+        va_end(ap);
+
+        if (program == NULL)
+                return 0;
+
+        return shader_data_finish_program(program);
+}
@@ -29,6 +29,20 @@
 #define SHADER_DATA_H
 
 #include <epoxy/gl.h>
+#include <stdbool.h>
+
+struct shader_data_cache_stats {
+        /* Programs loaded from a cached binary */
+        int hits;
+        /* Programs that had to be compiled */
+        int misses;
+        /* Cached binaries that the driver refused to load */
+        int rejected;
+};
+
+/* A program whose shaders have been submitted for compiling but that
+ * might not be finished yet */
+struct shader_data_program;
 
 char *
 shader_data_load_shader_source(const char *filename);
@@ -37,8 +51,45 @@ GLuint
 shader_data_load_shader(GLenum type,
                         const char *filename);
 
+/* Compiles and links a program from a list of shader types and
+ * filenames terminated by GL_NONE. If defines is not NULL it is
+ * inserted into every shader after the #version directive, for
+ * example "#define FOO 1\n". */
 GLuint
-shader_data_load_program(GLenum shader_type,
+shader_data_load_program(const char *defines,
+                         GLenum shader_type,
                          ...);
 
+/* Starts compiling and linking a program without waiting for the
+ * result. With GL_KHR_parallel_shader_compile the driver does this in
+ * the background so the caller can go on to submit programs for other
+ * contexts. The program must be finished with
+ * shader_data_finish_program with the same context bound. */
+struct shader_data_program *
+shader_data_submit_program(const char *defines,
+                           GLenum shader_type,
+                           ...);
+
+/* Checks whether the program can be finished without blocking */
+bool
+shader_data_program_is_ready(struct shader_data_program *program);
+
+/* Waits for the program to be compiled, reports any errors and frees
+ * the submission. Returns 0 if the program failed to link. */
+GLuint
+shader_data_finish_program(struct shader_data_program *program);
+
+/* Whether the current context can compile shaders in the background */
+bool
+shader_data_has_parallel_compile(void);
+
+/* Sets a directory in which to store the binaries of linked programs
+ * with GL_ARB_get_program_binary. The binaries are keyed on the
+ * shader sources and the driver version. NULL disables the cache. */
+bool
+shader_data_set_program_cache_dir(const char *dir);
+
+void
+shader_data_get_cache_stats(struct shader_data_cache_stats *stats);
+
 #endif /* SHADER_DATA_H */
@@ -27,10 +27,62 @@
 
 #version 330
 
+#ifdef PROCEDURAL_GRID
+
+/* The grid is generated from the vertex ID instead of a buffer. This
+ * must match make_grid in mct-draw-state.c */
+uniform ivec2 grid_size;
+
+vec2
+get_grid_pos()
+{
+        int row_length = grid_size.x * 2 + 2;
+        int row = gl_VertexID / row_length;
+        int column = gl_VertexID % row_length;
+        vec2 pos = vec2(float(column / 2) * 2.0 / float(grid_size.x) - 1.0,
+                        float(row) * 2.0 / float(grid_size.y) - 1.0);
+
+        if ((column & 1) == 0)
+                pos.y += 2.0 / float(grid_size.y);
+
+        return pos;
+}
+
+#else
+
 layout(location = 0) in vec2 pos;
 
+#endif
+
+#ifdef UNIFORM_BLOCK
+
+/* This must match struct mct_frame_state in mct-draw-state.c */
+layout(std140) uniform frame_state {
+        float band_pos;
+};
+
+#else
+
 uniform float band_pos;
 
+#endif
+
+#ifdef VERTEX_ALU
+
+/* Extra work that the result depends on so that it can't be
+ * optimized away. This must match the reference render so it is
+ * deterministic. */
+float
+vertex_alu(float x)
+{
+        for (int i = 0; i < VERTEX_ALU; i++)
+                x = fract(x * 1.618034 + 0.414214);
+
+        return x;
+}
+
+#endif
+
 const float band_width = 1.0 / 50.0;
 
 out vec3 color;
@@ -38,6 +90,9 @@ out vec3 color;
 void
 main()
 {
+#ifdef PROCEDURAL_GRID
+        vec2 pos = get_grid_pos();
+#endif
         float distance = length(pos);
 
         if (abs(band_pos - distance) < band_width)
@@ -45,5 +100,10 @@ main()
         else
                 color = vec3(0.0, 0.0, 1.0);
 
+#ifdef VERTEX_ALU
+        /* Too small to change the 8-bit color */
+        color.g += vertex_alu(distance) * 1.0e-4;
+#endif
+
         gl_Position = vec4(pos, 0.0, 1.0);
 }